@@ -0,0 +1,62 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <algorithm>
+#include <cmath>
+
+// Single-barrier knock-in/knock-out option on a call or put payoff
+struct BarrierOption {
+    enum class Type { UpOut, UpIn, DownOut, DownIn };
+
+    Type type = Type::DownOut;
+    double level = 0.0;
+    bool is_call = true;
+    double strike = 100.0;
+    double rate = 0.0;  // Continuously compounded discount rate
+
+    bool isUp() const { return type == Type::UpOut || type == Type::UpIn; }
+    bool knocksOut() const { return type == Type::UpOut || type == Type::DownOut; }
+
+    double payoff(double price) const {
+        return std::max(is_call ? price - strike : strike - price, 0.0);
+    }
+
+    bool breached(double price) const { return isUp() ? price >= level : price <= level; }
+};
+
+// Probability that the price crosses the barrier between two observations
+// s0 and s1, given that neither is beyond it. The log-price between two
+// observations is a Brownian bridge whatever the drift, so with
+// log_variance the variance of the log-return over the step the crossing
+// probability is exactly
+//     exp(-2 log(level / s0) log(level / s1) / log_variance)
+inline double bridgeCrossingProbability(double s0, double s1, double level, double log_variance) {
+    if (!(log_variance > 0.0)) return 0.0;
+    return std::exp(-2.0 * std::log(level / s0) * std::log(level / s1) / log_variance);
+}
+
+// Undiscounted payoff of one path prices[0..steps], both with the barrier
+// monitored only at the observations (discrete) and with the Brownian-bridge
+// correction between them (continuous monitoring). For the continuous value
+// the path survives with probability prod(1 - p_i) over the steps, so the
+// knock-out payoff is payoff * survival and the knock-in payoff is
+// payoff * (1 - survival), without any extra random numbers.
+inline void barrierPayoff(const double* prices, int steps, const double* log_variance, const BarrierOption& option,
+                          double& discrete, double& continuous) {
+    double survival = 1.0;
+    bool hit = option.breached(prices[0]);
+    for (int i = 1; i <= steps && !hit; ++i) {
+        if (option.breached(prices[i])) {
+            hit = true;
+        } else {
+            survival *= 1.0 - bridgeCrossingProbability(prices[i - 1], prices[i], option.level, log_variance[i - 1]);
+        }
+    }
+    if (hit) survival = 0.0;
+
+    double payoff = option.payoff(prices[steps]);
+    discrete = (hit != option.knocksOut()) ? payoff : 0.0;
+    continuous = option.knocksOut() ? payoff * survival : payoff * (1.0 - survival);
+}
+
+#endif // BARRIER_H
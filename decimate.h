@@ -0,0 +1,63 @@
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Largest-Triangle-Three-Buckets downsampling of the series (x[i], y[i]).
+// Returns the indices of at most `target` points that preserve the visual
+// shape: the first and last points are always kept, and from each of the
+// target - 2 buckets in between the point forming the largest triangle with
+// the previously kept point and the average of the next bucket is chosen.
+inline std::vector<std::size_t> lttbIndices(const double* x, const double* y, std::size_t n, std::size_t target) {
+    std::vector<std::size_t> kept;
+    if (target >= n || target < 3) {
+        kept.resize(n);
+        for (std::size_t i = 0; i < n; ++i) kept[i] = i;
+        return kept;
+    }
+
+    kept.reserve(target);
+    kept.push_back(0);
+    const double bucket_size = static_cast<double>(n - 2) / (target - 2);
+    std::size_t previous = 0;
+
+    for (std::size_t bucket = 0; bucket < target - 2; ++bucket) {
+        std::size_t begin = static_cast<std::size_t>(bucket * bucket_size) + 1;
+        std::size_t end = static_cast<std::size_t>((bucket + 1) * bucket_size) + 1;
+
+        // Average of the next bucket (the last point for the final bucket)
+        std::size_t next_begin = end;
+        std::size_t next_end = std::min(static_cast<std::size_t>((bucket + 2) * bucket_size) + 1, n);
+        if (next_begin >= next_end) {
+            next_begin = n - 1;
+            next_end = n;
+        }
+        double avg_x = 0.0, avg_y = 0.0;
+        for (std::size_t i = next_begin; i < next_end; ++i) {
+            avg_x += x[i];
+            avg_y += y[i];
+        }
+        avg_x /= (next_end - next_begin);
+        avg_y /= (next_end - next_begin);
+
+        double best_area = -1.0;
+        std::size_t best = begin;
+        for (std::size_t i = begin; i < end; ++i) {
+            double area = std::fabs((x[previous] - avg_x) * (y[i] - y[previous]) -
+                                    (x[previous] - x[i]) * (avg_y - y[previous]));
+            if (area > best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        kept.push_back(best);
+        previous = best;
+    }
+
+    kept.push_back(n - 1);
+    return kept;
+}
+
+#endif // DECIMATE_H
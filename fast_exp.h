@@ -0,0 +1,122 @@
+#ifndef FAST_EXP_H
+#define FAST_EXP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Accuracy tiers of the exponential used by the path kernels. Exact calls
+// std::exp; the others are branch-free polynomial approximations that the
+// compiler vectorizes, with a maximum relative error below the tier's bound
+// for every argument whose result is a normal double.
+enum class ExpTier { Exact, Tier1e15, Tier1e10, Tier1e6 };
+
+inline const char* expTierName(ExpTier tier) {
+    switch (tier) {
+        case ExpTier::Tier1e15: return "1e-15";
+        case ExpTier::Tier1e10: return "1e-10";
+        case ExpTier::Tier1e6: return "1e-6";
+        default: return "exact";
+    }
+}
+
+// Relative error bound of a tier (0 for std::exp)
+inline double expTierBound(ExpTier tier) {
+    switch (tier) {
+        case ExpTier::Tier1e15: return 1e-15;
+        case ExpTier::Tier1e10: return 1e-10;
+        case ExpTier::Tier1e6: return 1e-6;
+        default: return 0.0;
+    }
+}
+
+// Taylor polynomial degree per tier. After the reduction x = k ln2 + r,
+// |r| <= ln2 / 2, the truncation error is below (ln2/2)^(d+1) / (d+1)!:
+// 1.7e-16 for d = 12, 6.9e-12 for d = 9 and 1.2e-7 for d = 6.
+template <ExpTier Tier> struct ExpDegree;
+template <> struct ExpDegree<ExpTier::Tier1e15> { static constexpr int value = 12; };
+template <> struct ExpDegree<ExpTier::Tier1e10> { static constexpr int value = 9; };
+template <> struct ExpDegree<ExpTier::Tier1e6> { static constexpr int value = 6; };
+
+// 1/n! for n = 0 .. Degree, computed at compile time
+template <int Degree>
+struct InverseFactorials {
+    double c[Degree + 1];
+    constexpr InverseFactorials() : c() {
+        c[0] = 1.0;
+        for (int n = 1; n <= Degree; ++n) c[n] = c[n - 1] / n;
+    }
+};
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FAST_EXP_INLINE inline __attribute__((always_inline))
+#else
+#define FAST_EXP_INLINE inline
+#endif
+
+// sum_{n >= N} r^(n - N) / n!, unrolled at compile time so that the loops
+// calling it stay straight-line and vectorize
+template <int Degree, int N = 0>
+FAST_EXP_INLINE double taylorTail(double r) {
+    constexpr double kCoefficient = InverseFactorials<Degree>().c[N];
+    if constexpr (N == Degree) {
+        return kCoefficient;
+    } else {
+        return kCoefficient + r * taylorTail<Degree, N + 1>(r);
+    }
+}
+
+template <int Degree>
+FAST_EXP_INLINE double expPolynomial(double x) {
+    const double kLog2e = 1.4426950408889634;
+    const double kLn2Hi = 6.93147180369123816490e-01;  // Cody-Waite split of ln 2
+    const double kLn2Lo = 1.90821492927058770002e-10;
+    const double kRoundMagic = 6755399441055744.0;     // 1.5 * 2^52: adding it rounds to an integer
+
+    // Keep 2^k a normal double; results outside this range are not needed
+    x = std::min(std::max(x, -708.0), 709.0);
+    double shifted = x * kLog2e + kRoundMagic;
+    double k = shifted - kRoundMagic;
+    double r = (x - k * kLn2Hi) - k * kLn2Lo;
+
+    double p = taylorTail<Degree>(r);  // e^r by Horner's rule
+
+    // 2^k from the integer that the magic addition left in the low mantissa bits
+    std::int64_t shifted_bits;
+    std::memcpy(&shifted_bits, &shifted, sizeof(shifted));
+    std::int64_t magic_bits;
+    std::memcpy(&magic_bits, &kRoundMagic, sizeof(kRoundMagic));
+    std::int64_t scale_bits = (shifted_bits - magic_bits + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scale_bits, sizeof(scale));
+    return p * scale;
+}
+
+template <ExpTier Tier>
+struct TieredExp {
+    FAST_EXP_INLINE double operator()(double x) const { return expPolynomial<ExpDegree<Tier>::value>(x); }
+};
+
+template <>
+struct TieredExp<ExpTier::Exact> {
+    FAST_EXP_INLINE double operator()(double x) const { return std::exp(x); }
+};
+
+// x[j] = exp(x[j]) for j < n
+template <ExpTier Tier>
+void expInPlaceTier(double* x, int n) {
+    TieredExp<Tier> exp_fn;
+    for (int j = 0; j < n; ++j) x[j] = exp_fn(x[j]);
+}
+
+inline void expInPlace(ExpTier tier, double* x, int n) {
+    switch (tier) {
+        case ExpTier::Tier1e15: return expInPlaceTier<ExpTier::Tier1e15>(x, n);
+        case ExpTier::Tier1e10: return expInPlaceTier<ExpTier::Tier1e10>(x, n);
+        case ExpTier::Tier1e6: return expInPlaceTier<ExpTier::Tier1e6>(x, n);
+        default: return expInPlaceTier<ExpTier::Exact>(x, n);
+    }
+}
+
+#endif // FAST_EXP_H
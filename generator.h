@@ -0,0 +1,107 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Minimal synchronous generator for C++20 coroutines (std::generator only
+// arrives in C++23). A coroutine returning Generator<T> runs up to each
+// co_yield when the consumer asks for the next value, so producers hand out
+// data one piece at a time and nothing runs ahead of the consumer:
+//
+//     Generator<int> count(int n) { for (int i = 0; i < n; ++i) co_yield i; }
+//     for (int i : count(3)) ...
+//
+// Yielded values are passed by reference; they stay valid until the consumer
+// advances, and consumers may move from them.
+template <typename T>
+class Generator {
+public:
+    using value_type = std::remove_cv_t<std::remove_reference_t<T>>;
+    using reference = std::remove_reference_t<T>&;
+
+    struct promise_type {
+        std::remove_reference_t<T>* current = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        // A yielded temporary lives until the coroutine resumes
+        std::suspend_always yield_value(std::remove_reference_t<T>& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        std::suspend_always yield_value(std::remove_reference_t<T>&& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+        // Generators only yield; they never wait on other coroutines
+        template <typename U>
+        std::suspend_never await_transform(U&&) = delete;
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = Generator::value_type;
+
+        iterator() = default;
+        explicit iterator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        reference operator*() const { return *handle_.promise().current; }
+        iterator& operator++() {
+            resume(handle_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return !handle_ || handle_.done(); }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    Generator(Generator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+    // Destroying an unfinished generator simply drops the suspended producer
+    ~Generator() {
+        if (handle_) handle_.destroy();
+    }
+
+    // Runs the producer to its first co_yield; a generator can be iterated once
+    iterator begin() {
+        resume(handle_);
+        return iterator(handle_);
+    }
+    std::default_sentinel_t end() const { return {}; }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    static void resume(std::coroutine_handle<promise_type> handle) {
+        if (!handle || handle.done()) return;
+        handle.resume();
+        if (handle.promise().exception) std::rethrow_exception(std::exchange(handle.promise().exception, {}));
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+#endif // GENERATOR_H
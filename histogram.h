@@ -0,0 +1,111 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Histogram with logarithmically spaced bins over [lo, hi), suited to
+// lognormal data such as terminal stock prices. Values below lo or at/above
+// hi go to dedicated underflow/overflow counters. The exact minimum and
+// maximum of all added values are tracked alongside the counts.
+//
+// Each worker thread fills its own instance and the instances are merged at
+// the end, so no synchronization is needed while binning.
+class LogHistogram {
+public:
+    LogHistogram() = default;
+
+    LogHistogram(double lo, double hi, int bins)
+        : log_lo_(std::log(lo)),
+          inv_log_width_(bins / (std::log(hi) - std::log(lo))),
+          counts_(bins, 0) {}
+
+    void add(double x) {
+        ++total_;
+        min_ = std::min(min_, x);
+        max_ = std::max(max_, x);
+        long index = binIndex(x);
+        if (index < 0) {
+            ++underflow_;
+        } else if (index >= static_cast<long>(counts_.size())) {
+            ++overflow_;
+        } else {
+            ++counts_[index];
+        }
+    }
+
+    // Bin index of x: negative for underflow, >= bins() for overflow
+    long binIndex(double x) const {
+        if (!(x > 0.0)) return -1;
+        double position = (std::log(x) - log_lo_) * inv_log_width_;
+        if (position < 0.0) return -1;
+        if (position >= counts_.size()) return counts_.size();
+        return static_cast<long>(position);
+    }
+
+    // Add the counts of a histogram with identical binning
+    void merge(const LogHistogram& other) {
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        underflow_ += other.underflow_;
+        overflow_ += other.overflow_;
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    // Approximate p-quantile (0 <= p <= 1), interpolating geometrically within
+    // the bin. Accurate to within one bin width (a relative error of
+    // exp(binLogWidth()) - 1) unless the quantile falls into underflow/overflow,
+    // where the exact min/max bound is used for interpolation.
+    double quantile(double p) const {
+        if (total_ == 0) return std::nan("");
+        double target = p * total_;
+        double cumulative = underflow_;
+        if (target < cumulative) {
+            return interpolate(min_, lowerEdge(0), (target) / underflow_);
+        }
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            if (counts_[i] > 0 && target < cumulative + counts_[i]) {
+                double lo = std::max(lowerEdge(i), min_);
+                double hi = std::min(lowerEdge(i + 1), max_);
+                return interpolate(lo, hi, (target - cumulative) / counts_[i]);
+            }
+            cumulative += counts_[i];
+        }
+        if (overflow_ == 0) return max_;
+        return interpolate(upperBound(), max_, (target - cumulative) / overflow_);
+    }
+
+    double lowerEdge(std::size_t bin) const { return std::exp(log_lo_ + bin / inv_log_width_); }
+    double upperBound() const { return lowerEdge(counts_.size()); }
+    double binLogWidth() const { return 1.0 / inv_log_width_; }
+    int bins() const { return counts_.size(); }
+    std::uint64_t count(std::size_t bin) const { return counts_[bin]; }
+    std::uint64_t underflow() const { return underflow_; }
+    std::uint64_t overflow() const { return overflow_; }
+    std::uint64_t total() const { return total_; }
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+private:
+    static double interpolate(double lo, double hi, double fraction) {
+        if (!(lo > 0.0) || !(hi > lo)) return std::max(lo, 0.0);
+        return lo * std::pow(hi / lo, std::min(std::max(fraction, 0.0), 1.0));
+    }
+
+    double log_lo_ = 0.0;
+    double inv_log_width_ = 1.0;
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t underflow_ = 0;
+    std::uint64_t overflow_ = 0;
+    std::uint64_t total_ = 0;
+    double min_ = std::numeric_limits<double>::infinity();
+    double max_ = -std::numeric_limits<double>::infinity();
+};
+
+#endif // HISTOGRAM_H
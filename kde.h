@@ -0,0 +1,121 @@
+#ifndef KDE_H
+#define KDE_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "parallel.h"
+
+// In-place iterative radix-2 FFT; a.size() must be a power of two.
+// The inverse transform includes the 1/N scaling.
+inline void fft(std::vector<std::complex<double>>& a, bool inverse) {
+    const std::size_t n = a.size();
+    for (std::size_t i = 1, j = 0; i < n; ++i) {
+        std::size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    const double pi = std::acos(-1.0);
+    for (std::size_t len = 2; len <= n; len <<= 1) {
+        double angle = 2 * pi / len * (inverse ? 1 : -1);
+        std::complex<double> w_len(std::cos(angle), std::sin(angle));
+        for (std::size_t i = 0; i < n; i += len) {
+            std::complex<double> w(1.0);
+            for (std::size_t j = 0; j < len / 2; ++j) {
+                std::complex<double> u = a[i + j];
+                std::complex<double> v = a[i + j + len / 2] * w;
+                a[i + j] = u + v;
+                a[i + j + len / 2] = u - v;
+                w *= w_len;
+            }
+        }
+    }
+    if (inverse) {
+        for (auto& x : a) x /= static_cast<double>(n);
+    }
+}
+
+// Gaussian kernel density estimate evaluated on an equally spaced grid
+struct DensityEstimate {
+    std::vector<double> grid;     // Evaluation points
+    std::vector<double> density;  // Estimated density at each point
+    double bandwidth;
+};
+
+// Silverman's rule-of-thumb bandwidth for a Gaussian kernel
+inline double silvermanBandwidth(double std_dev, std::size_t n) {
+    return 1.06 * std_dev * std::pow(static_cast<double>(n), -0.2);
+}
+
+// Binned kernel density estimate: the samples are linearly binned onto
+// grid_size points spanning [lo, hi] (in parallel, with per-chunk bins), then
+// the bin weights are convolved with the sampled Gaussian kernel by FFT. The
+// cost is O(n + grid_size log grid_size), so it scales to very large samples.
+inline DensityEstimate binnedKde(const std::vector<double>& samples, double lo, double hi, double bandwidth,
+                                 int grid_size, int num_threads) {
+    DensityEstimate kde;
+    kde.bandwidth = bandwidth;
+    kde.grid.resize(grid_size);
+    kde.density.assign(grid_size, 0.0);
+    if (samples.empty() || grid_size < 2 || !(hi > lo) || !(bandwidth > 0.0)) return kde;
+
+    const double delta = (hi - lo) / (grid_size - 1);
+    for (int i = 0; i < grid_size; ++i) {
+        kde.grid[i] = lo + i * delta;
+    }
+
+    // Linear binning: each sample splits its weight between its two
+    // neighbours. Chunks are binned in parallel and their bins added in chunk
+    // order, so the estimate does not depend on the thread count.
+    const std::size_t chunk = 1 << 16;
+    int num_chunks = static_cast<int>((samples.size() + chunk - 1) / chunk);
+    OrderedReduction bins(num_chunks, std::vector<double>(grid_size, 0.0),
+                          [](std::vector<double>& total, const std::vector<double>& partial) {
+                              for (std::size_t i = 0; i < total.size(); ++i) total[i] += partial[i];
+                          });
+    parallelFor(num_chunks, num_threads, [&](int c, int) {
+        std::vector<double> weights(grid_size, 0.0);
+        std::size_t end = std::min(samples.size(), (c + 1) * chunk);
+        for (std::size_t i = c * chunk; i < end; ++i) {
+            double position = (samples[i] - lo) / delta;
+            if (!(position >= 0.0) || position > grid_size - 1) continue;
+            int left = std::min(static_cast<int>(position), grid_size - 2);
+            double fraction = position - left;
+            weights[left] += 1.0 - fraction;
+            weights[left + 1] += fraction;
+        }
+        bins.submit(c, std::move(weights));
+    });
+
+    // Kernel support is truncated at 5 bandwidths
+    int half_width = std::min(grid_size - 1, static_cast<int>(std::ceil(5.0 * bandwidth / delta)));
+    std::size_t fft_size = 1;
+    while (fft_size < static_cast<std::size_t>(grid_size + 2 * half_width)) fft_size <<= 1;
+
+    std::vector<std::complex<double>> weights(fft_size), kernel(fft_size);
+    for (int i = 0; i < grid_size; ++i) {
+        weights[i] = bins.result()[i];
+    }
+    const double norm = 1.0 / (samples.size() * bandwidth * std::sqrt(2.0 * std::acos(-1.0)));
+    for (int j = -half_width; j <= half_width; ++j) {
+        double u = j * delta / bandwidth;
+        // Negative offsets wrap around to the end of the (zero padded) buffer
+        kernel[(j + fft_size) % fft_size] = norm * std::exp(-0.5 * u * u);
+    }
+
+    fft(weights, false);
+    fft(kernel, false);
+    for (std::size_t i = 0; i < fft_size; ++i) weights[i] *= kernel[i];
+    fft(weights, true);
+
+    for (int i = 0; i < grid_size; ++i) {
+        kde.density[i] = std::max(0.0, weights[i].real());
+    }
+    return kde;
+}
+
+#endif // KDE_H
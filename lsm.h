@@ -0,0 +1,172 @@
+#ifndef LSM_H
+#define LSM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "parallel.h"
+
+// American/Bermudan option exercisable at a set of dates
+struct AmericanOption {
+    bool is_call = false;
+    double strike = 100.0;
+    double rate = 0.0;      // Continuously compounded discount rate
+    int basis_degree = 3;   // Regression on 1, x, ..., x^degree with x = S / strike
+
+    double payoff(double price) const {
+        return std::max(is_call ? price - strike : strike - price, 0.0);
+    }
+};
+
+struct LsmResult {
+    double price;
+    double std_error;
+    double european_price;  // Exercise only at the last date, from the same paths
+    double european_std_error;
+};
+
+// Solve the dense system a x = b (n x n, row-major) by Gaussian elimination
+// with partial pivoting; false if the matrix is numerically singular
+inline bool solveDense(std::vector<double> a, std::vector<double> b, int n, std::vector<double>& x) {
+    for (int col = 0; col < n; ++col) {
+        int pivot = col;
+        for (int row = col + 1; row < n; ++row) {
+            if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col])) pivot = row;
+        }
+        if (!(std::fabs(a[pivot * n + col]) > 1e-12 * std::fabs(a[0]))) return false;
+        if (pivot != col) {
+            for (int k = 0; k < n; ++k) std::swap(a[col * n + k], a[pivot * n + k]);
+            std::swap(b[col], b[pivot]);
+        }
+        for (int row = col + 1; row < n; ++row) {
+            double factor = a[row * n + col] / a[col * n + col];
+            for (int k = col; k < n; ++k) a[row * n + k] -= factor * a[col * n + k];
+            b[row] -= factor * b[col];
+        }
+    }
+    x.assign(n, 0.0);
+    for (int row = n - 1; row >= 0; --row) {
+        double sum = b[row];
+        for (int k = row + 1; k < n; ++k) sum -= a[row * n + k] * x[k];
+        x[row] = sum / a[row * n + row];
+    }
+    return true;
+}
+
+// Longstaff-Schwartz least-squares Monte Carlo.
+//
+// prices is a step-major matrix: row k (k = 0 .. times.size() - 1) holds the
+// prices of all num_paths paths at exercise date times[k] > 0, so every pass
+// of the backward induction streams through one contiguous row. At each date
+// the discounted realized cash flows of the in-the-money paths are regressed
+// on powers of S / strike; since the basis is monomial, the normal matrix is
+// the Hankel matrix of the power sums sum x^m, m = 0 .. 2 degree, and a whole
+// regression needs only 3 degree + 2 sums. The sums are accumulated over
+// fixed chunks of kReductionBlock paths and combined in chunk order, so the
+// price does not depend on the number of threads.
+inline LsmResult priceLongstaffSchwartz(const std::vector<double>& prices, const std::vector<double>& times,
+                                        int num_paths, double S0, const AmericanOption& option, int num_threads) {
+    const int num_dates = static_cast<int>(times.size());
+    const int degree = std::max(0, option.basis_degree);
+    const int num_basis = degree + 1;
+    const int num_sums = 3 * degree + 2;  // sum x^m for m <= 2 degree, then sum x^m V for m <= degree
+    const std::size_t n = num_paths;
+    const int num_chunks = static_cast<int>((n + kReductionBlock - 1) / kReductionBlock);
+    const double inv_strike = 1.0 / option.strike;
+
+    // Cash flow of each path, discounted to the current date
+    std::vector<double> value(n);
+    const double* last = &prices[(num_dates - 1) * n];
+    for (std::size_t p = 0; p < n; ++p) value[p] = option.payoff(last[p]);
+    double european_discount = std::exp(-option.rate * times.back());
+    double european_sum = deterministicSum(value.data(), n, num_threads) * european_discount;
+    double european_sum_squares = deterministicSum(value.data(), n, num_threads, [](double v) { return v * v; }) *
+                                  european_discount * european_discount;
+
+    std::vector<double> chunk_sums(static_cast<std::size_t>(num_chunks) * num_sums);
+    std::vector<std::vector<double>> scratch(num_threads, std::vector<double>(kReductionBlock));
+    std::vector<double> coefficients;
+
+    for (int k = num_dates - 2; k >= 0; --k) {
+        const double* row = &prices[k * n];
+        const double discount = std::exp(-option.rate * (times[k + 1] - times[k]));
+
+        // Discount to date k and accumulate the regression sums chunk by chunk
+        parallelFor(num_chunks, num_threads, [&](int chunk, int thread_id) {
+            std::size_t begin = chunk * kReductionBlock;
+            std::size_t count = std::min(kReductionBlock, n - begin);
+            double* v = &value[begin];
+            const double* s = &row[begin];
+            double* power = scratch[thread_id].data();  // In-the-money indicator times x^m
+            double* sums = &chunk_sums[static_cast<std::size_t>(chunk) * num_sums];
+
+            for (std::size_t j = 0; j < count; ++j) {
+                v[j] *= discount;
+                power[j] = option.payoff(s[j]) > 0.0 ? 1.0 : 0.0;
+            }
+            for (int m = 0; m <= 2 * degree; ++m) {
+                double sum = 0.0, sum_value = 0.0;
+                for (std::size_t j = 0; j < count; ++j) {
+                    sum += power[j];
+                    sum_value += power[j] * v[j];
+                }
+                sums[m] = sum;
+                if (m <= degree) sums[2 * degree + 1 + m] = sum_value;
+                for (std::size_t j = 0; j < count; ++j) power[j] *= s[j] * inv_strike;
+            }
+        });
+
+        std::vector<double> totals(num_sums);
+        for (int m = 0; m < num_sums; ++m) {
+            CompensatedSum sum;
+            for (int chunk = 0; chunk < num_chunks; ++chunk) {
+                sum.add(chunk_sums[static_cast<std::size_t>(chunk) * num_sums + m]);
+            }
+            totals[m] = sum.value();
+        }
+        // Too few in-the-money paths to fit the regression: no exercise at this date
+        if (totals[0] < 2 * num_basis) continue;
+
+        std::vector<double> normal(num_basis * num_basis), rhs(num_basis);
+        for (int a = 0; a < num_basis; ++a) {
+            for (int b = 0; b < num_basis; ++b) normal[a * num_basis + b] = totals[a + b];
+            rhs[a] = totals[2 * degree + 1 + a];
+        }
+        if (!solveDense(normal, rhs, num_basis, coefficients)) continue;
+
+        // Exercise where the immediate payoff beats the fitted continuation value
+        parallelFor(num_chunks, num_threads, [&](int chunk, int) {
+            std::size_t begin = chunk * kReductionBlock;
+            std::size_t end = std::min(begin + kReductionBlock, n);
+            for (std::size_t p = begin; p < end; ++p) {
+                double exercise = option.payoff(row[p]);
+                if (exercise <= 0.0) continue;
+                double x = row[p] * inv_strike;
+                double continuation = coefficients[degree];
+                for (int m = degree - 1; m >= 0; --m) continuation = continuation * x + coefficients[m];
+                if (exercise > continuation) value[p] = exercise;
+            }
+        });
+    }
+
+    const double discount = std::exp(-option.rate * times.front());
+    double sum = deterministicSum(value.data(), n, num_threads) * discount;
+    double sum_squares = deterministicSum(value.data(), n, num_threads, [](double v) { return v * v; }) *
+                         discount * discount;
+
+    auto standardError = [n](double total, double total_squares) {
+        double mean = total / n;
+        double variance = n > 1 ? std::max(total_squares - n * mean * mean, 0.0) / (n - 1) : 0.0;
+        return std::sqrt(variance / n);
+    };
+    LsmResult result;
+    result.price = std::max(sum / n, option.payoff(S0));
+    result.std_error = standardError(sum, sum_squares);
+    result.european_price = european_sum / n;
+    result.european_std_error = standardError(european_sum, european_sum_squares);
+    return result;
+}
+
+#endif // LSM_H
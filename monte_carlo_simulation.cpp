@@ -7,6 +7,55 @@
 #include <algorithm>
 #include <iomanip>
 #include <chrono>
+#include <cstdint>
+#include <thread>
+#include <limits>
+#include <stdexcept>
+#include <functional>
+#include <sstream>
+#include <memory>
+#include <filesystem>
+
+#include "barrier.h"
+#include "decimate.h"
+#include "fast_exp.h"
+#include "generator.h"
+#include "histogram.h"
+#include "kde.h"
+#include "lsm.h"
+#include "nested.h"
+#include "parallel.h"
+#include "path_metrics.h"
+#include "path_store.h"
+#include "price_index.h"
+#include "progress.h"
+#include "radix_sort.h"
+#include "result_cache.h"
+#include "rng.h"
+#include "sde.h"
+#include "shared_results.h"
+#include "term_structure.h"
+#include "tick_stream.h"
+#include "time_grid.h"
+
+// Stochastic process followed by the simulated price
+enum class SdeModel {
+    Gbm,                // dS = mu S dt + sigma S dW
+    OrnsteinUhlenbeck,  // dS = kappa (theta - S) dt + sigma dW
+    Cir,                // dS = kappa (theta - S) dt + sigma sqrt(S) dW
+    Cev                 // dS = mu S dt + sigma S^beta dW
+};
+
+// Discretization: Exact uses the closed-form GBM transition (GBM only)
+enum class SdeScheme { Exact, Euler, Milstein };
+
+struct ModelSpec {
+    SdeModel model = SdeModel::Gbm;
+    SdeScheme scheme = SdeScheme::Exact;
+    double kappa = 1.0;   // Mean-reversion speed (OU, CIR)
+    double theta = 0.0;   // Mean-reversion level (OU, CIR)
+    double beta = 0.5;    // Elasticity (CEV)
+};
 
 // Parameters for the simulation
 struct SimulationParams {
@@ -16,132 +65,1304 @@ struct SimulationParams {
     double T;            // Time period in years
     int steps;           // Number of time steps
     int num_paths;       // Number of simulation paths
+    TermStructure mu_curve;     // Time-dependent drift mu(t); overrides mu when set
+    TermStructure sigma_curve;  // Time-dependent volatility sigma(t); overrides sigma when set
+    std::vector<double> time_grid;  // Explicit times t_0 = 0 < ... < t_steps = T; empty for equal steps
+    ModelSpec model;     // Process and scheme; term structures apply to exact GBM only
 };
 
+// Time in years of step i
+double stepTime(const SimulationParams& params, int i) {
+    return params.time_grid.empty() ? i * (params.T / params.steps) : params.time_grid[i];
+}
+
+// Log-price increment of every step, S(i+1) = S(i) * exp(drift[i] + vol[i] * Z).
+// Computed once per run and shared by all paths, so the hot loop never
+// evaluates the model parameters.
+struct StepCoefficients {
+    std::vector<double> drift;  // Integral of mu - sigma^2/2 over the step
+    std::vector<double> vol;    // Square root of the integral of sigma^2 over the step
+};
+
+StepCoefficients makeStepCoefficients(const SimulationParams& params) {
+    StepCoefficients coeffs;
+    coeffs.drift.resize(params.steps);
+    coeffs.vol.resize(params.steps);
+    for (int i = 0; i < params.steps; ++i) {
+        // Exact GBM transition over [t0, t1], however long the interval
+        double t0 = stepTime(params, i);
+        double t1 = stepTime(params, i + 1);
+        double dt = t1 - t0;
+        double mu_integral = params.mu_curve.empty() ? params.mu * dt : params.mu_curve.integral(t0, t1);
+        double variance = params.sigma_curve.empty() ? params.sigma * params.sigma * dt
+                                                     : params.sigma_curve.integralOfSquare(t0, t1);
+        coeffs.drift[i] = mu_integral - 0.5 * variance;
+        coeffs.vol[i] = std::sqrt(variance);
+    }
+    return coeffs;
+}
+
 // Generate a single path of stock prices using Geometric Brownian Motion
-std::vector<double> generatePath(const SimulationParams& params, std::mt19937& gen) {
+std::vector<double> generatePath(const SimulationParams& params, const StepCoefficients& coeffs,
+                                 NormalStream& normals, ExpTier exp_tier = ExpTier::Exact) {
     std::vector<double> path(params.steps + 1);
     path[0] = params.S0;
     
-    // Time step size
-    double dt = params.T / params.steps;
+    // Random normal shocks for the whole path, drawn in one batch into the path itself
+    normals.fill(path.data() + 1, params.steps);
+    
+    // Generate the path: growth factors exp(drift + vol * Z) in one batch, then their running product
+    for (int i = 1; i <= params.steps; ++i) {
+        double Z = path[i];
+        path[i] = coeffs.drift[i-1] + coeffs.vol[i-1] * Z;
+    }
+    expInPlace(exp_tier, path.data() + 1, params.steps);
+    for (int i = 1; i <= params.steps; ++i) {
+        path[i] *= path[i-1];
+    }
+    
+    return path;
+}
+
+// Order in which the engine generates prices
+enum class PathLayout {
+    PathMajor,  // One path from step 0 to steps, then the next path
+    StepMajor   // A block of paths advanced together one step at a time
+};
+
+// Instruction set variant of the simulation kernels
+enum class KernelIsa {
+    Auto,     // Best variant supported by the CPU
+    Generic,  // Baseline build flags
+    Avx2,     // AVX2 + FMA
+    Avx512    // AVX-512F/DQ
+};
+
+// Engine settings that do not change the model
+struct EngineConfig {
+    int num_threads = 1;        // Worker threads
+    std::uint64_t seed = 0;     // Base seed shared by all path blocks
+    int histogram_bins = 4096;  // Log-spaced bins for the final price histogram
+    PathLayout layout = PathLayout::StepMajor;
+    int block_size = 256;       // Paths advanced in lockstep by the step-major engine
+    KernelIsa isa = KernelIsa::Auto;
+    bool show_progress = false; // Report progress on stderr while paths are generated
+    RngEngine rng = RngEngine::Mt19937;
+    ExpTier exp_tier = ExpTier::Exact;  // Accuracy of the exponential in the GBM kernels
+};
+
+// Cross-sectional statistics of the price at every time step
+struct StepStatistics {
+    std::vector<double> sum;
+    std::vector<double> sum_squares;
+    std::vector<double> min;
+    std::vector<double> max;
+    long count = 0;
+    
+    explicit StepStatistics(int steps = 0)
+        : sum(steps + 1, 0.0), sum_squares(steps + 1, 0.0),
+          min(steps + 1, std::numeric_limits<double>::infinity()),
+          max(steps + 1, -std::numeric_limits<double>::infinity()) {}
     
-    // Precompute some values for efficiency
-    double drift = (params.mu - 0.5 * params.sigma * params.sigma) * dt;
-    double vol = params.sigma * std::sqrt(dt);
+    // Add the prices of n paths at one step
+    void add(int step, const double* prices, int n) {
+        double s = 0.0, s2 = 0.0, lo = min[step], hi = max[step];
+        for (int j = 0; j < n; ++j) {
+            s += prices[j];
+            s2 += prices[j] * prices[j];
+            lo = std::min(lo, prices[j]);
+            hi = std::max(hi, prices[j]);
+        }
+        sum[step] += s;
+        sum_squares[step] += s2;
+        min[step] = lo;
+        max[step] = hi;
+    }
     
-    // Normal distribution for random shocks
-    std::normal_distribution<double> dist(0.0, 1.0);
+    void merge(const StepStatistics& other) {
+        for (std::size_t i = 0; i < sum.size(); ++i) {
+            sum[i] += other.sum[i];
+            sum_squares[i] += other.sum_squares[i];
+            min[i] = std::min(min[i], other.min[i]);
+            max[i] = std::max(max[i], other.max[i]);
+        }
+        count += other.count;
+    }
+};
+
+// The step kernel is compiled once per instruction set and chosen at startup
+// from CPUID, so one binary runs on every machine and uses the widest vectors
+// available. Dispatch is only available with GCC/Clang on x86.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MC_CPU_DISPATCH 1
+#define MC_ALWAYS_INLINE inline __attribute__((always_inline))
+#define MC_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MC_ALWAYS_INLINE inline
+#endif
+
+// Advance a block of n prices by one GBM step: prices[j] *= exp(drift + vol * z[j]),
+// with the exponential of the given accuracy tier (vectorized unless Exact)
+template <ExpTier Tier>
+MC_ALWAYS_INLINE void advanceStepBody(double* prices, const double* z, int n, double drift, double vol) {
+    TieredExp<Tier> exp_fn;
+    for (int j = 0; j < n; ++j) {
+        prices[j] *= exp_fn(drift + vol * z[j]);
+    }
+}
+
+template <ExpTier Tier>
+void advanceStepGeneric(double* prices, const double* z, int n, double drift, double vol) {
+    advanceStepBody<Tier>(prices, z, n, drift, vol);
+}
+
+#ifdef MC_CPU_DISPATCH
+template <ExpTier Tier>
+MC_TARGET("avx2,fma")
+void advanceStepAvx2(double* prices, const double* z, int n, double drift, double vol) {
+    advanceStepBody<Tier>(prices, z, n, drift, vol);
+}
+
+template <ExpTier Tier>
+MC_TARGET("avx512f,avx512dq,avx2,fma,prefer-vector-width=512")
+void advanceStepAvx512(double* prices, const double* z, int n, double drift, double vol) {
+    advanceStepBody<Tier>(prices, z, n, drift, vol);
+}
+#endif
+
+// A resolved kernel variant
+struct StepKernel {
+    KernelIsa isa;
+    const char* name;
+    void (*advance)(double* prices, const double* z, int n, double drift, double vol);
+    ExpTier tier;
+};
+
+bool cpuSupports(KernelIsa isa) {
+#ifdef MC_CPU_DISPATCH
+    switch (isa) {
+        case KernelIsa::Avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+        case KernelIsa::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        default:
+            return true;
+    }
+#else
+    return isa == KernelIsa::Generic || isa == KernelIsa::Auto;
+#endif
+}
+
+// Pick the kernel for the requested ISA. Auto selects the widest supported
+// variant; an explicit request the CPU cannot run falls back to generic.
+template <ExpTier Tier>
+StepKernel selectStepKernelForTier(KernelIsa requested) {
+#ifdef MC_CPU_DISPATCH
+    if (requested == KernelIsa::Auto) {
+        requested = cpuSupports(KernelIsa::Avx512) ? KernelIsa::Avx512
+                  : cpuSupports(KernelIsa::Avx2)   ? KernelIsa::Avx2
+                                                   : KernelIsa::Generic;
+    }
+    if (requested == KernelIsa::Avx512 && cpuSupports(KernelIsa::Avx512)) {
+        return {KernelIsa::Avx512, "avx512", advanceStepAvx512<Tier>, Tier};
+    }
+    if (requested == KernelIsa::Avx2 && cpuSupports(KernelIsa::Avx2)) {
+        return {KernelIsa::Avx2, "avx2", advanceStepAvx2<Tier>, Tier};
+    }
+#endif
+    (void)requested;
+    return {KernelIsa::Generic, "generic", advanceStepGeneric<Tier>, Tier};
+}
+
+StepKernel selectStepKernel(KernelIsa requested, ExpTier tier = ExpTier::Exact) {
+    switch (tier) {
+        case ExpTier::Tier1e15: return selectStepKernelForTier<ExpTier::Tier1e15>(requested);
+        case ExpTier::Tier1e10: return selectStepKernelForTier<ExpTier::Tier1e10>(requested);
+        case ExpTier::Tier1e6: return selectStepKernelForTier<ExpTier::Tier1e6>(requested);
+        default: return selectStepKernelForTier<ExpTier::Exact>(requested);
+    }
+}
+
+// Generate paths [begin, end) in lockstep: the current prices of the whole
+// block stay in a small contiguous buffer (L1/L2 resident) and every step
+// draws the shocks for all paths at once, then advances them together
+void generateBlockStepMajor(const SimulationParams& params, const StepCoefficients& coeffs, const StepKernel& kernel,
+                            NormalStream& normals, int begin, int end, std::vector<std::vector<double>>& paths,
+                            StepStatistics* step_stats, PathMetricsTracker* tracker) {
+    int n = end - begin;
+    std::vector<double> prices(n, params.S0);
+    std::vector<double> z(n);
+    for (int j = 0; j < n; ++j) {
+        paths[begin + j].resize(params.steps + 1);
+        paths[begin + j][0] = params.S0;
+    }
+    if (step_stats) {
+        step_stats->add(0, prices.data(), n);
+        step_stats->count += n;
+    }
     
-    // Generate the path
     for (int i = 1; i <= params.steps; ++i) {
-        double Z = dist(gen);  // Random normal shock
-        path[i] = path[i-1] * std::exp(drift + vol * Z);
+        normals.fill(z.data(), n);
+        kernel.advance(prices.data(), z.data(), n, coeffs.drift[i - 1], coeffs.vol[i - 1]);
+        for (int j = 0; j < n; ++j) {
+            paths[begin + j][i] = prices[j];
+        }
+        if (step_stats) step_stats->add(i, prices.data(), n);
+        if (tracker) tracker->update(i, prices.data());
+    }
+}
+
+// Paths are generated in fixed-size blocks, each with its own generator derived
+// from (seed, block index), so the results do not depend on the thread count
+const int kPathsPerBlock = 1024;
+
+std::unique_ptr<NormalStream> blockGenerator(const EngineConfig& config, int block) {
+    return makeNormalStream(config.rng, config.seed, block);
+}
+
+// Generate paths [begin, end) of a generic SDE in lockstep, like
+// generateBlockStepMajor but stepping with the given scheme
+template <typename Scheme>
+void generateBlockSde(const SimulationParams& params, const Scheme& scheme, NormalStream& normals, int begin, int end,
+                      std::vector<std::vector<double>>& paths, StepStatistics* step_stats,
+                      PathMetricsTracker* tracker) {
+    int n = end - begin;
+    std::vector<double> prices(n, params.S0);
+    std::vector<double> z(n);
+    for (int j = 0; j < n; ++j) {
+        paths[begin + j].resize(params.steps + 1);
+        paths[begin + j][0] = params.S0;
+    }
+    if (step_stats) {
+        step_stats->add(0, prices.data(), n);
+        step_stats->count += n;
     }
     
-    return path;
+    for (int i = 1; i <= params.steps; ++i) {
+        normals.fill(z.data(), n);
+        double t = stepTime(params, i - 1);
+        advanceSde(scheme, prices.data(), z.data(), n, t, stepTime(params, i) - t);
+        for (int j = 0; j < n; ++j) {
+            paths[begin + j][i] = prices[j];
+        }
+        if (step_stats) step_stats->add(i, prices.data(), n);
+        if (tracker) tracker->update(i, prices.data());
+    }
+}
+
+// Block generator for a generic SDE: (gen, begin, end, paths, step_stats, tracker)
+using SdeBlockGenerator = std::function<void(NormalStream&, int, int, std::vector<std::vector<double>>&,
+                                             StepStatistics*, PathMetricsTracker*)>;
+
+template <typename Drift, typename Diffusion>
+SdeBlockGenerator bindSdeScheme(const SimulationParams& params, const Drift& drift, const Diffusion& diffusion) {
+    // The scheme type carries the model, so generateBlockSde is instantiated
+    // (and inlined) per model; only the per-block call goes through std::function
+    if (params.model.scheme == SdeScheme::Milstein) {
+        auto scheme = milsteinScheme(drift, diffusion);
+        return [&params, scheme](NormalStream& normals, int begin, int end, std::vector<std::vector<double>>& paths,
+                                 StepStatistics* step_stats, PathMetricsTracker* tracker) {
+            generateBlockSde(params, scheme, normals, begin, end, paths, step_stats, tracker);
+        };
+    }
+    auto scheme = eulerScheme(drift, diffusion);
+    return [&params, scheme](NormalStream& normals, int begin, int end, std::vector<std::vector<double>>& paths,
+                             StepStatistics* step_stats, PathMetricsTracker* tracker) {
+        generateBlockSde(params, scheme, normals, begin, end, paths, step_stats, tracker);
+    };
+}
+
+// Generator for params.model, or an empty function for the exact GBM kernel.
+// params must outlive the returned generator.
+SdeBlockGenerator makeSdeBlockGenerator(const SimulationParams& params) {
+    const ModelSpec& m = params.model;
+    if (m.scheme == SdeScheme::Exact) return {};
+    auto S = stateVar();
+    switch (m.model) {
+        case SdeModel::Gbm:
+            return bindSdeScheme(params, params.mu * S, params.sigma * S);
+        case SdeModel::OrnsteinUhlenbeck:
+            return bindSdeScheme(params, m.kappa * (m.theta - S), ExprConst{params.sigma});
+        case SdeModel::Cir:
+            return bindSdeScheme(params, m.kappa * (m.theta - S), params.sigma * sqrtPos(S));
+        case SdeModel::Cev:
+            return bindSdeScheme(params, params.mu * S, params.sigma * powPos(S, m.beta));
+    }
+    return {};
 }
 
-// Run the Monte Carlo simulation and return all paths
-std::vector<std::vector<double>> runMonteCarloSimulation(const SimulationParams& params) {
-    // Initialize random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
+// Empty histogram covering +-10 standard deviations of the lognormal final price
+LogHistogram makeFinalPriceHistogram(const SimulationParams& params, const StepCoefficients& coeffs, int bins) {
+    double total_drift = 0.0;
+    double total_variance = 0.0;
+    for (int i = 0; i < params.steps; ++i) {
+        total_drift += coeffs.drift[i];
+        total_variance += coeffs.vol[i] * coeffs.vol[i];
+    }
+    double center = std::log(params.S0) + total_drift;
+    double spread = 10.0 * std::max(std::sqrt(total_variance), 0.01);
+    return LogHistogram(std::exp(center - spread), std::exp(center + spread), bins);
+}
+
+// Everything needed to generate one seeding block of paths: the kernels and
+// coefficients resolved once per run, shared by all blocks and threads.
+// params must outlive the engine.
+struct BlockEngine {
+    const SimulationParams& params;
+    const EngineConfig& config;
+    StepKernel kernel;
+    StepCoefficients coeffs;
+    SdeBlockGenerator sde_generator;
+    
+    BlockEngine(const SimulationParams& p, const EngineConfig& c)
+        : params(p), config(c), kernel(selectStepKernel(c.isa, c.exp_tier)), coeffs(makeStepCoefficients(p)),
+          sde_generator(makeSdeBlockGenerator(p)) {}
     
-    // Generate multiple paths
-    std::vector<std::vector<double>> paths(params.num_paths);
-    for (int i = 0; i < params.num_paths; ++i) {
-        paths[i] = generatePath(params, gen);
+    // Whether the kernels fill per-step statistics (lockstep generation only)
+    bool tracksSteps() const { return sde_generator || config.layout == PathLayout::StepMajor; }
+    
+    // Generate the paths of seeding block `block` into target[i - offset]
+    void generate(int block, std::vector<std::vector<double>>& target, int offset, StepStatistics* step_stats,
+                  PathMetrics* metrics) const {
+        std::unique_ptr<NormalStream> normals = blockGenerator(config, block);
+        int begin = block * kPathsPerBlock;
+        int end = std::min(begin + kPathsPerBlock, params.num_paths);
+        int lockstep_width = std::max(1, std::min(config.block_size, kPathsPerBlock));
+        
+        if (tracksSteps()) {
+            for (int sub = begin; sub < end; sub += lockstep_width) {
+                int sub_end = std::min(sub + lockstep_width, end);
+                std::unique_ptr<PathMetricsTracker> tracker;
+                if (metrics) tracker = std::make_unique<PathMetricsTracker>(*metrics, sub, sub_end - sub, params.S0);
+                if (sde_generator) {
+                    sde_generator(*normals, sub - offset, sub_end - offset, target, step_stats, tracker.get());
+                } else {
+                    generateBlockStepMajor(params, coeffs, kernel, *normals, sub - offset, sub_end - offset, target,
+                                           step_stats, tracker.get());
+                }
+                if (tracker) tracker->finish();
+            }
+        } else {
+            for (int i = begin; i < end; ++i) {
+                target[i - offset] = generatePath(params, coeffs, *normals, config.exp_tier);
+                if (metrics) {
+                    const std::vector<double>& path = target[i - offset];
+                    PathMetricsTracker tracker(*metrics, i, 1, params.S0);
+                    for (int step = 1; step <= params.steps; ++step) tracker.update(step, &path[step]);
+                    tracker.finish();
+                }
+            }
+        }
+    }
+};
+
+// Run the Monte Carlo simulation and return all paths. Worker threads bin the
+// final prices into private histograms, which are merged into *histogram.
+// The step-major layout also fills *step_stats with per-step statistics.
+// With a compressed store, each block of paths is compressed into *store as
+// soon as it is generated and the returned vector is empty. With *metrics,
+// the kernels also track every path's drawdown and first passage as they go.
+// With a publisher that carries paths, every block is copied to shared memory
+// and flagged ready as soon as it is done.
+std::vector<std::vector<double>> runMonteCarloSimulation(const SimulationParams& params, const EngineConfig& config,
+                                                         LogHistogram* histogram = nullptr,
+                                                         StepStatistics* step_stats = nullptr,
+                                                         CompressedPathStore* store = nullptr,
+                                                         PathMetrics* metrics = nullptr,
+                                                         SharedResultsPublisher* publisher = nullptr) {
+    std::vector<std::vector<double>> paths(store ? 0 : params.num_paths);
+    int num_blocks = (params.num_paths + kPathsPerBlock - 1) / kPathsPerBlock;
+    int num_threads = std::max(1, std::min(config.num_threads, num_blocks));
+    
+    BlockEngine engine(params, config);
+    std::unique_ptr<ProgressReporter> progress;
+    if (config.show_progress) {
+        progress = std::make_unique<ProgressReporter>(params.num_paths, num_threads);
     }
     
+    std::vector<LogHistogram> thread_histograms(num_threads, makeFinalPriceHistogram(params, engine.coeffs,
+                                                                                     config.histogram_bins));
+    // Step statistics are merged per block in block order, so they do not
+    // depend on the thread count (the histogram only counts)
+    bool track_steps = engine.tracksSteps() && step_stats;
+    OrderedReduction block_step_stats(track_steps ? num_blocks : 0, StepStatistics(params.steps),
+                                      [](StepStatistics& total, const StepStatistics& partial) {
+                                          total.merge(partial);
+                                      });
+    
+    parallelFor(num_blocks, num_threads, [&](int block, int thread_id) {
+        LogHistogram& local_histogram = thread_histograms[thread_id];
+        StepStatistics block_stats(track_steps ? params.steps : 0);
+        StepStatistics* local_step_stats = track_steps ? &block_stats : nullptr;
+        int begin = block * kPathsPerBlock;
+        int end = std::min(begin + kPathsPerBlock, params.num_paths);
+        
+        // When compressing, the block is generated into a temporary buffer
+        std::vector<std::vector<double>> block_paths(store ? end - begin : 0);
+        std::vector<std::vector<double>>& target = store ? block_paths : paths;
+        int offset = store ? begin : 0;
+        
+        engine.generate(block, target, offset, local_step_stats, metrics);
+        if (track_steps) block_step_stats.submit(block, std::move(block_stats));
+        for (int i = begin; i < end; ++i) {
+            local_histogram.add(target[i - offset][params.steps]);
+            if (store) store->storePath(i, target[i - offset].data());
+        }
+        if (publisher && publisher->publishesPaths()) {
+            for (int i = begin; i < end; ++i) {
+                publisher->writePath(i, target[i - offset].data());
+            }
+            publisher->markBlockReady(block);
+        }
+        if (progress) progress->add(thread_id, end - begin);
+    });
+    if (progress) progress->finish();
+    
+    if (histogram) {
+        *histogram = thread_histograms[0];
+        for (int t = 1; t < num_threads; ++t) {
+            histogram->merge(thread_histograms[t]);
+        }
+    }
+    if (track_steps) *step_stats = std::move(block_step_stats.result());
+    
     return paths;
 }
 
-// Calculate statistics from the simulation results
-void calculateStatistics(const std::vector<std::vector<double>>& paths, const SimulationParams& params) {
-    int num_paths = paths.size();
-    int steps = params.steps;
+// A seeding block of consecutive paths: paths[k] is path first + k
+struct PathBlock {
+    int first = 0;
+    std::vector<std::vector<double>> paths;
+};
+
+// Lazy counterpart of runMonteCarloSimulation: yields the paths in order, one
+// seeding block at a time, as the consumer pulls them. Each time the consumer
+// has taken every block of the previous batch, the next num_threads blocks
+// are generated in parallel, so at most one batch of paths is held in memory
+// and the paths are identical to those of runMonteCarloSimulation. Histogram,
+// step statistics and path metrics, if given, are complete once the
+// generator is exhausted; each block's kernels fill the metrics of its own
+// paths. params and config are copied into the coroutine.
+Generator<PathBlock&> simulatePathBlocks(SimulationParams params, EngineConfig config,
+                                         LogHistogram* histogram = nullptr, StepStatistics* step_stats = nullptr,
+                                         PathMetrics* metrics = nullptr) {
+    int num_blocks = (params.num_paths + kPathsPerBlock - 1) / kPathsPerBlock;
+    int batch_size = std::max(1, std::min(config.num_threads, num_blocks));
+    BlockEngine engine(params, config);
+    if (histogram) *histogram = makeFinalPriceHistogram(params, engine.coeffs, config.histogram_bins);
+    if (step_stats) *step_stats = StepStatistics(params.steps);
     
-    // Extract final prices
+    std::vector<PathBlock> batch(batch_size);
+    std::vector<StepStatistics> batch_step_stats(engine.tracksSteps() && step_stats ? batch_size : 0);
+    for (int first_block = 0; first_block < num_blocks; first_block += batch_size) {
+        int count = std::min(batch_size, num_blocks - first_block);
+        parallelFor(count, count, [&](int k, int) {
+            int block = first_block + k;
+            PathBlock& out = batch[k];
+            out.first = block * kPathsPerBlock;
+            out.paths.assign(std::min(kPathsPerBlock, params.num_paths - out.first), {});
+            StepStatistics* local_step_stats = nullptr;
+            if (!batch_step_stats.empty()) {
+                batch_step_stats[k] = StepStatistics(params.steps);
+                local_step_stats = &batch_step_stats[k];
+            }
+            engine.generate(block, out.paths, out.first, local_step_stats, metrics);
+        });
+        for (int k = 0; k < count; ++k) {
+            if (histogram) {
+                for (const auto& path : batch[k].paths) histogram->add(path[params.steps]);
+            }
+            if (!batch_step_stats.empty()) step_stats->merge(batch_step_stats[k]);
+            co_yield batch[k];
+        }
+    }
+}
+
+// Extract the final price of every path
+std::vector<double> extractFinalPrices(const std::vector<std::vector<double>>& paths, const SimulationParams& params) {
     std::vector<double> final_prices;
+    final_prices.reserve(paths.size());
     for (const auto& path : paths) {
-        final_prices.push_back(path[steps]);
+        final_prices.push_back(path[params.steps]);
+    }
+    return final_prices;
+}
+
+// Decode the final price of every compressed path, in parallel over blocks
+std::vector<double> extractFinalPrices(const CompressedPathStore& store, int num_threads) {
+    std::vector<double> final_prices(store.numPaths());
+    int num_blocks = (store.numPaths() + kPathsPerBlock - 1) / kPathsPerBlock;
+    parallelFor(num_blocks, num_threads, [&](int block, int) {
+        int end = std::min((block + 1) * kPathsPerBlock, store.numPaths());
+        for (int i = block * kPathsPerBlock; i < end; ++i) {
+            final_prices[i] = store.finalPrice(i);
+        }
+    });
+    return final_prices;
+}
+
+// Visit the paths in blocks as fn(first_path_index, block_of_paths). Stored
+// paths are visited as a single block; compressed paths are decoded one block
+// at a time so only a block is ever held uncompressed.
+template <typename Fn>
+void forEachPathBlock(const std::vector<std::vector<double>>& paths, Fn fn) {
+    fn(0, paths);
+}
+
+template <typename Fn>
+void forEachPathBlock(const CompressedPathStore& store, Fn fn) {
+    for (int first = 0; first < store.numPaths(); first += kPathsPerBlock) {
+        fn(first, store.decodeBlock(first, kPathsPerBlock));
+    }
+}
+
+// Inverse of the standard normal CDF (Acklam's rational approximation,
+// relative error below 1.2e-9)
+double normalQuantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double p_low = 0.02425;
+    if (p < p_low) {
+        double q = std::sqrt(-2 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
     }
+    if (p > 1 - p_low) {
+        return -normalQuantile(1 - p);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+// A point estimate with its standard error and confidence interval
+struct Estimate {
+    double value;
+    double std_error;
+    double ci_low;
+    double ci_high;
+};
+
+// Statistics of the final stock price
+struct FinalPriceStatistics {
+    int num_paths;
+    double confidence;      // Confidence level of the intervals, e.g. 0.95
+    Estimate mean;
+    Estimate std_dev;
+    double min_price;
+    double max_price;
+    Estimate percentile_5;
+    Estimate percentile_95;
+    int histogram_bins;     // > 0 when min/max and percentiles come from the histogram
+    double bin_width;       // Relative width of a histogram bin
+};
+
+// Calculate statistics from the simulation results. When a final price
+// histogram is given, min/max and percentiles are read from it instead of
+// sorting all final prices. The mean and standard deviation use deterministic
+// parallel reductions, so they are bit-identical for any number of threads.
+//
+// Standard errors use the asymptotic formulas: s/sqrt(n) for the mean and
+// sqrt((m4 - s^4) / (4 s^2 n)) for the standard deviation (m4 is the fourth
+// central moment). Percentile intervals are distribution-free order-statistic
+// intervals at ranks n*p -/+ z*sqrt(n*p*(1-p)).
+FinalPriceStatistics calculateStatistics(const std::vector<double>& final_prices, int num_threads,
+                                         double confidence = 0.95, const LogHistogram* histogram = nullptr) {
+    int num_paths = final_prices.size();
     
     // Calculate mean
-    double sum = 0.0;
-    for (double price : final_prices) {
-        sum += price;
-    }
+    double sum = deterministicSum(final_prices.data(), final_prices.size(), num_threads);
     double mean = sum / num_paths;
     
     // Calculate standard deviation
-    double sum_squared_diff = 0.0;
-    for (double price : final_prices) {
-        sum_squared_diff += (price - mean) * (price - mean);
-    }
+    double sum_squared_diff = deterministicSum(final_prices.data(), final_prices.size(), num_threads,
+                                               [mean](double price) { return (price - mean) * (price - mean); });
     double std_dev = std::sqrt(sum_squared_diff / num_paths);
+    double sum_fourth_diff = deterministicSum(final_prices.data(), final_prices.size(), num_threads,
+                                              [mean](double price) { return std::pow(price - mean, 4); });
+    
+    FinalPriceStatistics stats;
+    stats.num_paths = num_paths;
+    stats.confidence = confidence;
+    stats.histogram_bins = 0;
+    stats.bin_width = 0.0;
+    double z = normalQuantile(0.5 + 0.5 * confidence);
+    
+    double mean_se = std_dev / std::sqrt(num_paths);
+    stats.mean = {mean, mean_se, mean - z * mean_se, mean + z * mean_se};
     
-    // Calculate min and max
-    double min_price = *std::min_element(final_prices.begin(), final_prices.end());
-    double max_price = *std::max_element(final_prices.begin(), final_prices.end());
+    double variance = std_dev * std_dev;
+    double fourth_moment = sum_fourth_diff / num_paths;
+    double std_dev_se = variance > 0.0
+        ? std::sqrt(std::max(0.0, fourth_moment - variance * variance) / (4.0 * variance * num_paths))
+        : 0.0;
+    stats.std_dev = {std_dev, std_dev_se, std_dev - z * std_dev_se, std_dev + z * std_dev_se};
     
-    // Calculate percentiles (5% and 95%)
-    std::vector<double> sorted_prices = final_prices;
-    std::sort(sorted_prices.begin(), sorted_prices.end());
-    double percentile_5 = sorted_prices[static_cast<int>(0.05 * num_paths)];
-    double percentile_95 = sorted_prices[static_cast<int>(0.95 * num_paths)];
+    std::vector<double> sorted_prices;
+    std::function<double(double)> quantile;
+    if (histogram) {
+        stats.min_price = histogram->min();
+        stats.max_price = histogram->max();
+        stats.histogram_bins = histogram->bins();
+        stats.bin_width = std::exp(histogram->binLogWidth()) - 1.0;
+        quantile = [histogram](double p) { return histogram->quantile(p); };
+    } else {
+        // Calculate min and max
+        stats.min_price = *std::min_element(final_prices.begin(), final_prices.end());
+        stats.max_price = *std::max_element(final_prices.begin(), final_prices.end());
+        
+        // Exact percentiles from a parallel radix sort
+        sorted_prices = final_prices;
+        radixSort(sorted_prices, num_threads);
+        quantile = [&sorted_prices, num_paths](double p) {
+            int index = static_cast<int>(p * num_paths);
+            return sorted_prices[std::min(std::max(index, 0), num_paths - 1)];
+        };
+    }
+    
+    // Calculate percentiles (5% and 95%) with order-statistic intervals
+    auto percentile = [&](double p) {
+        double rank_spread = z * std::sqrt(p * (1.0 - p) / num_paths);
+        Estimate e;
+        e.value = quantile(p);
+        e.ci_low = quantile(std::max(0.0, p - rank_spread));
+        e.ci_high = quantile(std::min(1.0, p + rank_spread));
+        e.std_error = (e.ci_high - e.ci_low) / (2.0 * z);
+        return e;
+    };
+    stats.percentile_5 = percentile(0.05);
+    stats.percentile_95 = percentile(0.95);
+    
+    return stats;
+}
+
+// Print the statistics. With target_half_width > 0, also print how many paths
+// each estimate needs for a confidence interval of +-target_half_width dollars
+// (half-widths shrink as 1/sqrt(num_paths)).
+void printStatistics(const FinalPriceStatistics& stats, double target_half_width = 0.0) {
+    int level = static_cast<int>(std::lround(stats.confidence * 100));
+    auto printEstimate = [&](const char* label, const Estimate& e) {
+        std::cout << label << ": $" << std::fixed << std::setprecision(2) << e.value
+                  << " (SE $" << e.std_error << ", " << level << "% CI $" << e.ci_low << " - $" << e.ci_high << ")"
+                  << std::endl;
+    };
     
-    // Print statistics
     std::cout << "\nSimulation Statistics (Final Stock Price):\n";
     std::cout << "----------------------------------------\n";
-    std::cout << "Mean: $" << std::fixed << std::setprecision(2) << mean << std::endl;
-    std::cout << "Standard Deviation: $" << std::fixed << std::setprecision(2) << std_dev << std::endl;
-    std::cout << "Minimum: $" << std::fixed << std::setprecision(2) << min_price << std::endl;
-    std::cout << "Maximum: $" << std::fixed << std::setprecision(2) << max_price << std::endl;
-    std::cout << "5th Percentile: $" << std::fixed << std::setprecision(2) << percentile_5 << std::endl;
-    std::cout << "95th Percentile: $" << std::fixed << std::setprecision(2) << percentile_95 << std::endl;
+    printEstimate("Mean", stats.mean);
+    printEstimate("Standard Deviation", stats.std_dev);
+    std::cout << "Minimum: $" << std::fixed << std::setprecision(2) << stats.min_price << std::endl;
+    std::cout << "Maximum: $" << std::fixed << std::setprecision(2) << stats.max_price << std::endl;
+    printEstimate("5th Percentile", stats.percentile_5);
+    printEstimate("95th Percentile", stats.percentile_95);
+    if (stats.histogram_bins > 0) {
+        std::cout << "(Percentiles from " << stats.histogram_bins << "-bin log histogram, bin width "
+                  << std::setprecision(3) << stats.bin_width * 100 << "%)" << std::endl;
+    }
+    
+    if (target_half_width > 0.0) {
+        std::cout << "\nPaths needed for a " << level << "% CI of +-$" << std::setprecision(2) << target_half_width
+                  << ":\n";
+        auto printRequired = [&](const char* label, const Estimate& e) {
+            double half_width = 0.5 * (e.ci_high - e.ci_low);
+            double ratio = half_width / target_half_width;
+            std::cout << "  " << label << ": " << static_cast<long long>(std::ceil(stats.num_paths * ratio * ratio))
+                      << std::endl;
+        };
+        printRequired("Mean", stats.mean);
+        printRequired("Standard Deviation", stats.std_dev);
+        printRequired("5th Percentile", stats.percentile_5);
+        printRequired("95th Percentile", stats.percentile_95);
+    }
 }
 
-// Save simulation results to CSV files for plotting
-void saveResultsToCSV(const std::vector<std::vector<double>>& paths, const SimulationParams& params) {
-    // Save all paths to a single CSV file
-    std::ofstream all_paths_file("stock_price_paths.csv");
+// Prices of all paths at the given steps as a step-major matrix: row k holds
+// every path at date_steps[k], so memory is date_steps.size() * num_paths
+// doubles whatever the number of steps
+template <typename PathSource>
+std::vector<double> gatherPricesAtSteps(const PathSource& paths, const SimulationParams& params,
+                                        const std::vector<int>& date_steps) {
+    const std::size_t n = params.num_paths;
+    std::vector<double> matrix(date_steps.size() * n);
+    forEachPathBlock(paths, [&](int first, const std::vector<std::vector<double>>& block) {
+        for (std::size_t p = 0; p < block.size(); ++p) {
+            for (std::size_t k = 0; k < date_steps.size(); ++k) {
+                matrix[k * n + first + p] = block[p][date_steps[k]];
+            }
+        }
+    });
+    return matrix;
+}
+
+// Factors that move GBM paths from the simulated drift to the risk-neutral
+// drift `rate`: driven by the same shocks, the risk-neutral price at step i
+// is the simulated one times exp(rate * t_i - integral of mu over [0, t_i]).
+// Exact for the GBM kernels, with or without a mu term structure.
+std::vector<double> riskNeutralFactors(const SimulationParams& params, double rate) {
+    StepCoefficients coeffs = makeStepCoefficients(params);
+    std::vector<double> factors(params.steps + 1, 1.0);
+    double mu_integral = 0.0;
+    for (int i = 1; i <= params.steps; ++i) {
+        mu_integral += coeffs.drift[i - 1] + 0.5 * coeffs.vol[i - 1] * coeffs.vol[i - 1];
+        factors[i] = std::exp(rate * stepTime(params, i) - mu_integral);
+    }
+    return factors;
+}
+
+// Price an American option on the simulated paths with Longstaff-Schwartz,
+// exercisable at num_dates equally spaced steps, the last one at T. Paths of
+// the exact GBM scheme are first moved to the risk-neutral drift option.rate;
+// discretized models must be simulated with mu equal to the rate.
+template <typename PathSource>
+LsmResult priceAmericanOption(const PathSource& paths, const SimulationParams& params, const AmericanOption& option,
+                              int num_dates, int num_threads) {
+    num_dates = std::max(1, std::min(num_dates, params.steps));
+    std::vector<int> date_steps(num_dates);
+    std::vector<double> times(num_dates);
+    for (int k = 0; k < num_dates; ++k) {
+        date_steps[k] = static_cast<int>(static_cast<long long>(k + 1) * params.steps / num_dates);
+        times[k] = stepTime(params, date_steps[k]);
+    }
+    std::vector<double> matrix = gatherPricesAtSteps(paths, params, date_steps);
+    if (params.model.scheme == SdeScheme::Exact) {
+        std::vector<double> factors = riskNeutralFactors(params, option.rate);
+        const std::size_t n = params.num_paths;
+        parallelFor(num_dates, num_threads, [&](int k, int) {
+            double factor = factors[date_steps[k]];
+            for (std::size_t p = 0; p < n; ++p) matrix[k * n + p] *= factor;
+        });
+    }
+    return priceLongstaffSchwartz(matrix, times, params.num_paths, params.S0, option, num_threads);
+}
+
+// Exposure profile of a long European option: at each date the option is
+// valued on every outer path by an inner simulation to maturity, giving the
+// expected exposure (mean value) and the potential future exposure (95th
+// percentile of the value across outer paths)
+struct ExposureProfile {
+    std::vector<double> times;
+    std::vector<double> expected_exposure;
+    std::vector<double> expected_exposure_error;  // Outer standard error
+    std::vector<double> pfe_95;
+    std::vector<double> inner_std_error;          // Mean inner standard error of a path's value
+    long long inner_evaluations = 0;
+};
+
+// Outer paths follow the simulated (real-world) dynamics; inner scenarios
+// are risk-neutral GBM from the date to maturity with drift option.rate and
+// the same volatility, in one exact step since the payoff only needs S_T.
+// One set of num_inner normalized shocks, drawn from its own generator
+// stream, is reused at every date and for every outer path.
+template <typename PathSource>
+ExposureProfile computeExposureProfile(const PathSource& paths, const SimulationParams& params,
+                                       const EngineConfig& config, const VanillaOption& option, int num_dates,
+                                       int num_inner) {
+    num_dates = std::max(1, std::min(num_dates, params.steps));
+    std::vector<int> date_steps(num_dates);
+    for (int k = 0; k < num_dates; ++k) {
+        date_steps[k] = static_cast<int>(static_cast<long long>(k) * params.steps / num_dates);
+    }
+    std::vector<double> matrix = gatherPricesAtSteps(paths, params, date_steps);
+    
+    const std::uint64_t kInnerStream = 0xFFFFFFFFu;  // Not used by any outer block
+    std::vector<double> shocks(num_inner);
+    makeNormalStream(config.rng, config.seed, kInnerStream)->fill(shocks.data(), shocks.size());
+    
+    const std::size_t n = params.num_paths;
+    std::vector<double> values(n), errors(n), growth(num_inner);
+    ExposureProfile profile;
+    for (int k = 0; k < num_dates; ++k) {
+        double t = stepTime(params, date_steps[k]);
+        double variance = params.sigma_curve.empty() ? params.sigma * params.sigma * (params.T - t)
+                                                     : params.sigma_curve.integralOfSquare(t, params.T);
+        double drift = option.rate * (params.T - t) - 0.5 * variance;
+        double vol = std::sqrt(variance);
+        for (int j = 0; j < num_inner; ++j) {
+            growth[j] = std::exp(drift + vol * shocks[j]);
+        }
+        
+        valueWithInnerSimulation(&matrix[k * n], n, growth, std::exp(-option.rate * (params.T - t)),
+                                 [&option](double price) { return option.payoff(price); }, config.num_threads,
+                                 values.data(), errors.data());
+        
+        double mean = deterministicSum(values.data(), n, config.num_threads) / n;
+        double sum_squares = deterministicSum(values.data(), n, config.num_threads,
+                                              [mean](double v) { return (v - mean) * (v - mean); });
+        std::nth_element(values.begin(), values.begin() + static_cast<std::size_t>(0.95 * (n - 1)), values.end());
+        profile.times.push_back(t);
+        profile.expected_exposure.push_back(mean);
+        profile.expected_exposure_error.push_back(n > 1 ? std::sqrt(sum_squares / (n - 1) / n) : 0.0);
+        profile.pfe_95.push_back(values[static_cast<std::size_t>(0.95 * (n - 1))]);
+        profile.inner_std_error.push_back(deterministicSum(errors.data(), n, config.num_threads) / n);
+        profile.inner_evaluations += static_cast<long long>(n) * num_inner;
+    }
+    return profile;
+}
+
+void printExposureProfile(const ExposureProfile& profile, const VanillaOption& option, int num_inner,
+                          double seconds) {
+    std::size_t peak_ee = std::max_element(profile.expected_exposure.begin(), profile.expected_exposure.end()) -
+                          profile.expected_exposure.begin();
+    std::size_t peak_pfe = std::max_element(profile.pfe_95.begin(), profile.pfe_95.end()) - profile.pfe_95.begin();
+    std::cout << "\nExposure Profile (long European " << (option.is_call ? "call" : "put") << ", strike $"
+              << std::fixed << std::setprecision(2) << option.strike << ", " << profile.times.size() << " dates, "
+              << num_inner << " inner paths):\n";
+    std::cout << "----------------------------------------\n";
+    std::cout << "Value at t = 0: $" << std::setprecision(4) << profile.expected_exposure[0] << " (inner SE $"
+              << profile.inner_std_error[0] << ")" << std::endl;
+    std::cout << "Peak expected exposure: $" << profile.expected_exposure[peak_ee] << " at t = "
+              << std::setprecision(3) << profile.times[peak_ee] << std::endl;
+    std::cout << "Peak 95% PFE: $" << std::setprecision(4) << profile.pfe_95[peak_pfe] << " at t = "
+              << std::setprecision(3) << profile.times[peak_pfe] << std::endl;
+    std::cout << profile.inner_evaluations << " inner evaluations in " << seconds << " seconds ("
+              << std::setprecision(1) << profile.inner_evaluations / seconds / 1e6 << " million/sec)" << std::endl;
+}
+
+void saveExposureProfileToCSV(const ExposureProfile& profile) {
+    std::ofstream file("exposure_profile.csv");
+    file << "Time,ExpectedExposure,ExpectedExposureStdError,PFE95,InnerStdError" << std::endl;
+    for (std::size_t k = 0; k < profile.times.size(); ++k) {
+        file << profile.times[k] << "," << profile.expected_exposure[k] << ","
+             << profile.expected_exposure_error[k] << "," << profile.pfe_95[k] << "," << profile.inner_std_error[k]
+             << std::endl;
+    }
+    std::cout << "Exposure profile saved to exposure_profile.csv" << std::endl;
+}
+
+// Price a barrier option on the simulated paths, with the barrier monitored
+// at the time steps only and continuously (Brownian-bridge correction). The
+// paths are moved to the risk-neutral drift option.rate (riskNeutralFactors);
+// the step variances, and with them the bridge correction, are unchanged.
+struct BarrierResult {
+    Estimate discrete;
+    Estimate continuous;
+};
+
+template <typename PathSource>
+BarrierResult priceBarrierOption(const PathSource& paths, const SimulationParams& params, const BarrierOption& option,
+                                 double confidence, int num_threads) {
+    StepCoefficients coeffs = makeStepCoefficients(params);
+    std::vector<double> log_variance(params.steps);
+    for (int i = 0; i < params.steps; ++i) {
+        log_variance[i] = coeffs.vol[i] * coeffs.vol[i];
+    }
+    
+    std::vector<double> factors = riskNeutralFactors(params, option.rate);
+    
+    std::vector<double> discrete(params.num_paths), continuous(params.num_paths);
+    forEachPathBlock(paths, [&](int first, const std::vector<std::vector<double>>& block) {
+        int count = static_cast<int>(block.size());
+        int num_chunks = (count + kPathsPerBlock - 1) / kPathsPerBlock;
+        parallelFor(num_chunks, num_threads, [&](int chunk, int) {
+            std::vector<double> path(params.steps + 1);
+            int end = std::min(count, (chunk + 1) * kPathsPerBlock);
+            for (int p = chunk * kPathsPerBlock; p < end; ++p) {
+                for (int i = 0; i <= params.steps; ++i) path[i] = block[p][i] * factors[i];
+                barrierPayoff(path.data(), params.steps, log_variance.data(), option, discrete[first + p],
+                              continuous[first + p]);
+            }
+        });
+    });
+    
+    double discount = std::exp(-option.rate * params.T);
+    double z = normalQuantile(0.5 + 0.5 * confidence);
+    auto estimate = [&](const std::vector<double>& values) {
+        std::size_t n = values.size();
+        double mean = deterministicSum(values.data(), n, num_threads) / n;
+        double sum_squares = deterministicSum(values.data(), n, num_threads,
+                                              [mean](double v) { return (v - mean) * (v - mean); });
+        Estimate e;
+        e.value = discount * mean;
+        e.std_error = n > 1 ? discount * std::sqrt(sum_squares / (n - 1) / n) : 0.0;
+        e.ci_low = e.value - z * e.std_error;
+        e.ci_high = e.value + z * e.std_error;
+        return e;
+    };
+    return {estimate(discrete), estimate(continuous)};
+}
+
+const char* barrierTypeName(BarrierOption::Type type) {
+    switch (type) {
+        case BarrierOption::Type::UpOut: return "up-and-out";
+        case BarrierOption::Type::UpIn: return "up-and-in";
+        case BarrierOption::Type::DownIn: return "down-and-in";
+        default: return "down-and-out";
+    }
+}
+
+void printBarrierOption(const BarrierResult& result, const BarrierOption& option, int steps, double confidence) {
+    int level = static_cast<int>(std::lround(confidence * 100));
+    auto printPrice = [&](const char* label, const Estimate& e) {
+        std::cout << label << ": $" << std::fixed << std::setprecision(4) << e.value << " (SE $" << e.std_error
+                  << ", " << level << "% CI $" << e.ci_low << " - $" << e.ci_high << ")" << std::endl;
+    };
+    
+    std::cout << "\nBarrier " << (option.is_call ? "Call" : "Put") << " (" << barrierTypeName(option.type)
+              << " at $" << std::fixed << std::setprecision(2) << option.level << ", strike $" << option.strike
+              << ", rate " << option.rate * 100 << "%):\n";
+    std::cout << "----------------------------------------\n";
+    std::cout << "Monitored at " << steps << " steps:\n";
+    printPrice("  Discrete", result.discrete);
+    printPrice("  Continuous (Brownian bridge)", result.continuous);
+}
+
+void printAmericanOption(const LsmResult& result, const AmericanOption& option, int num_dates, double confidence) {
+    double z = normalQuantile(0.5 + 0.5 * confidence);
+    int level = static_cast<int>(std::lround(confidence * 100));
+    auto printPrice = [&](const char* label, double price, double std_error) {
+        std::cout << label << ": $" << std::fixed << std::setprecision(4) << price << " (SE $" << std_error << ", "
+                  << level << "% CI $" << price - z * std_error << " - $" << price + z * std_error << ")"
+                  << std::endl;
+    };
+    
+    std::cout << "\nAmerican " << (option.is_call ? "Call" : "Put") << " (Longstaff-Schwartz, strike $"
+              << std::fixed << std::setprecision(2) << option.strike << ", rate " << option.rate * 100 << "%, "
+              << num_dates << " exercise dates, degree " << option.basis_degree << " basis):\n";
+    std::cout << "----------------------------------------\n";
+    printPrice("American price", result.price, result.std_error);
+    printPrice("European price", result.european_price, result.european_std_error);
+    std::cout << "Early exercise premium: $" << std::setprecision(4) << result.price - result.european_price
+              << std::endl;
+}
+
+// Save the final price histogram with its log-spaced bin edges and density
+void saveHistogramToCSV(const LogHistogram& histogram) {
+    std::ofstream histogram_file("final_price_histogram.csv");
+    histogram_file << "Lower,Upper,Count,Density" << std::endl;
+    
+    double total = static_cast<double>(histogram.total());
+    if (histogram.underflow() > 0) {
+        histogram_file << 0 << "," << histogram.lowerEdge(0) << "," << histogram.underflow() << "," << std::endl;
+    }
+    for (int i = 0; i < histogram.bins(); ++i) {
+        double lower = histogram.lowerEdge(i);
+        double upper = histogram.lowerEdge(i + 1);
+        histogram_file << lower << "," << upper << "," << histogram.count(i) << ","
+                       << histogram.count(i) / (total * (upper - lower)) << std::endl;
+    }
+    if (histogram.overflow() > 0) {
+        histogram_file << histogram.upperBound() << "," << histogram.max() << "," << histogram.overflow() << "," << std::endl;
+    }
+    
+    histogram_file.close();
+    std::cout << "Final price histogram saved to final_price_histogram.csv" << std::endl;
+}
+
+// Save the mean, standard deviation, min and max of the price at every time step
+void saveStepStatisticsToCSV(const StepStatistics& step_stats, const SimulationParams& params,
+                             const std::string& engine) {
+    std::ofstream stats_file("step_statistics.csv");
+    stats_file << "# Engine: " << engine << std::endl;
+    stats_file << "Time,Mean,StdDev,Min,Max" << std::endl;
     
-    // Write header (time steps)
-    all_paths_file << "Path,";
     for (int i = 0; i <= params.steps; ++i) {
-        double t = i * (params.T / params.steps);
-        all_paths_file << t;
-        if (i < params.steps) all_paths_file << ",";
+        double t = stepTime(params, i);
+        double mean = step_stats.sum[i] / step_stats.count;
+        double variance = std::max(0.0, step_stats.sum_squares[i] / step_stats.count - mean * mean);
+        stats_file << t << "," << mean << "," << std::sqrt(variance) << ","
+                   << step_stats.min[i] << "," << step_stats.max[i] << std::endl;
     }
-    all_paths_file << std::endl;
     
-    // Write each path
-    for (int i = 0; i < params.num_paths; ++i) {
-        all_paths_file << i + 1 << ",";
-        for (int j = 0; j <= params.steps; ++j) {
-            all_paths_file << paths[i][j];
-            if (j < params.steps) all_paths_file << ",";
+    stats_file.close();
+    std::cout << "Per-step statistics saved to step_statistics.csv" << std::endl;
+}
+
+// Distributions of the maximum drawdown and the first passage time
+struct PathMetricsSummary {
+    Estimate mean_drawdown;
+    double drawdown_median = 0.0;
+    double drawdown_95 = 0.0;
+    double drawdown_99 = 0.0;
+    Estimate passage_probability;  // Fraction of paths reaching the level by T
+    double passage_time_mean = 0.0;    // Conditional on reaching the level
+    double passage_time_median = 0.0;
+    double passage_time_95 = 0.0;
+    std::vector<long> drawdown_counts;  // 1% bins of drawdown
+    std::vector<long> passage_counts;   // Paths first reaching the level at each step
+};
+
+PathMetricsSummary summarizePathMetrics(const PathMetrics& metrics, const SimulationParams& params,
+                                        int num_threads, double confidence) {
+    PathMetricsSummary summary;
+    const std::size_t n = metrics.max_drawdown.size();
+    double z = normalQuantile(0.5 + 0.5 * confidence);
+    auto quantile = [](const std::vector<double>& sorted, double p) {
+        std::size_t index = static_cast<std::size_t>(p * sorted.size());
+        return sorted[std::min(index, sorted.size() - 1)];
+    };
+    
+    double mean = deterministicSum(metrics.max_drawdown.data(), n, num_threads) / n;
+    double sum_squares = deterministicSum(metrics.max_drawdown.data(), n, num_threads,
+                                          [mean](double d) { return (d - mean) * (d - mean); });
+    summary.mean_drawdown.value = mean;
+    summary.mean_drawdown.std_error = n > 1 ? std::sqrt(sum_squares / (n - 1) / n) : 0.0;
+    summary.mean_drawdown.ci_low = mean - z * summary.mean_drawdown.std_error;
+    summary.mean_drawdown.ci_high = mean + z * summary.mean_drawdown.std_error;
+    
+    std::vector<double> sorted(metrics.max_drawdown);
+    std::sort(sorted.begin(), sorted.end());
+    summary.drawdown_median = quantile(sorted, 0.5);
+    summary.drawdown_95 = quantile(sorted, 0.95);
+    summary.drawdown_99 = quantile(sorted, 0.99);
+    summary.drawdown_counts.assign(100, 0);
+    for (double d : metrics.max_drawdown) {
+        ++summary.drawdown_counts[std::min(static_cast<int>(d * 100), 99)];
+    }
+    
+    if (!metrics.tracksPassage()) return summary;
+    summary.passage_counts.assign(params.steps + 1, 0);
+    std::vector<double> times;
+    for (int step : metrics.passage_step) {
+        if (step < 0) continue;
+        ++summary.passage_counts[step];
+        times.push_back(stepTime(params, step));
+    }
+    double p = static_cast<double>(times.size()) / n;
+    summary.passage_probability.value = p;
+    summary.passage_probability.std_error = std::sqrt(p * (1.0 - p) / n);
+    summary.passage_probability.ci_low = std::max(0.0, p - z * summary.passage_probability.std_error);
+    summary.passage_probability.ci_high = std::min(1.0, p + z * summary.passage_probability.std_error);
+    if (!times.empty()) {
+        // Times were collected in path order, so the sum is reproducible
+        summary.passage_time_mean = deterministicSum(times.data(), times.size(), num_threads) / times.size();
+        std::sort(times.begin(), times.end());
+        summary.passage_time_median = quantile(times, 0.5);
+        summary.passage_time_95 = quantile(times, 0.95);
+    }
+    return summary;
+}
+
+void printPathMetrics(const PathMetricsSummary& summary, const PathMetrics& metrics, double confidence) {
+    int level = static_cast<int>(std::lround(confidence * 100));
+    std::cout << "\nPath Statistics:\n";
+    std::cout << "----------------------------------------\n";
+    const Estimate& dd = summary.mean_drawdown;
+    std::cout << "Mean maximum drawdown: " << std::fixed << std::setprecision(2) << dd.value * 100 << "% (SE "
+              << dd.std_error * 100 << "%, " << level << "% CI " << dd.ci_low * 100 << "% - " << dd.ci_high * 100
+              << "%)" << std::endl;
+    std::cout << "Maximum drawdown median / 95th / 99th percentile: " << summary.drawdown_median * 100 << "% / "
+              << summary.drawdown_95 * 100 << "% / " << summary.drawdown_99 * 100 << "%" << std::endl;
+    if (!metrics.tracksPassage()) return;
+    const Estimate& hit = summary.passage_probability;
+    std::cout << "Probability of " << (metrics.passage_up ? "rising" : "falling") << " to $" << metrics.passage_level
+              << ": " << hit.value * 100 << "% (SE " << hit.std_error * 100 << "%, " << level << "% CI "
+              << hit.ci_low * 100 << "% - " << hit.ci_high * 100 << "%)" << std::endl;
+    if (hit.value > 0.0) {
+        std::cout << "First passage time given a passage, mean / median / 95th percentile: " << std::setprecision(3)
+                  << summary.passage_time_mean << " / " << summary.passage_time_median << " / "
+                  << summary.passage_time_95 << " years" << std::endl;
+    }
+}
+
+// Save the drawdown histogram and, when tracked, the first passage time distribution
+void savePathMetricsToCSV(const PathMetricsSummary& summary, const SimulationParams& params, std::size_t num_paths) {
+    std::ofstream drawdown_file("drawdown_histogram.csv");
+    drawdown_file << "DrawdownLow,DrawdownHigh,Count,Probability" << std::endl;
+    for (std::size_t i = 0; i < summary.drawdown_counts.size(); ++i) {
+        drawdown_file << i / 100.0 << "," << (i + 1) / 100.0 << "," << summary.drawdown_counts[i] << ","
+                      << static_cast<double>(summary.drawdown_counts[i]) / num_paths << std::endl;
+    }
+    std::cout << "Maximum drawdown histogram saved to drawdown_histogram.csv" << std::endl;
+    
+    if (summary.passage_counts.empty()) return;
+    std::ofstream passage_file("first_passage.csv");
+    passage_file << "Time,Count,CumulativeProbability" << std::endl;
+    long cumulative = 0;
+    for (int i = 0; i <= params.steps; ++i) {
+        cumulative += summary.passage_counts[i];
+        passage_file << stepTime(params, i) << "," << summary.passage_counts[i] << ","
+                     << static_cast<double>(cumulative) / num_paths << std::endl;
+    }
+    std::cout << "First passage time distribution saved to first_passage.csv" << std::endl;
+}
+
+// Smooth density of the final price: a binned Gaussian KDE (Silverman bandwidth)
+// on a grid extending three bandwidths beyond the observed range. Samples
+// without spread (e.g. zero volatility) give no bandwidth; the kernel then
+// gets a width of 0.1% of the mean price (at least 0.001), so the density is
+// a narrow spike instead of all zeros.
+DensityEstimate estimateFinalPriceDensity(const std::vector<double>& final_prices, const FinalPriceStatistics& stats,
+                                          int grid_size, int num_threads) {
+    double bandwidth = silvermanBandwidth(stats.std_dev.value, final_prices.size());
+    if (!(bandwidth > 0.0)) bandwidth = 1e-3 * std::max(std::fabs(stats.mean.value), 1.0);
+    double lo = std::max(0.0, stats.min_price - 3.0 * bandwidth);
+    double hi = stats.max_price + 3.0 * bandwidth;
+    return binnedKde(final_prices, lo, hi, bandwidth, grid_size, num_threads);
+}
+
+// Save the estimated final price density
+void saveDensityToCSV(const DensityEstimate& kde) {
+    std::ofstream density_file("terminal_density.csv");
+    density_file << "Price,Density" << std::endl;
+    for (std::size_t i = 0; i < kde.grid.size(); ++i) {
+        density_file << kde.grid[i] << "," << kde.density[i] << std::endl;
+    }
+    density_file.close();
+    std::cout << "Final price density (bandwidth $" << std::fixed << std::setprecision(2) << kde.bandwidth
+              << ") saved to terminal_density.csv" << std::endl;
+}
+
+// Writes stock_price_paths.csv one block of paths at a time, so paths can be
+// written as they are generated or decoded. A comment line naming the engine
+// precedes the header.
+class PathsCsvWriter {
+public:
+    PathsCsvWriter(const SimulationParams& params, const std::string& engine)
+        : params_(params), file_("stock_price_paths.csv") {
+        file_ << "# Engine: " << engine << std::endl;
+        // Write header (time steps)
+        file_ << "Path,";
+        for (int i = 0; i <= params_.steps; ++i) {
+            double t = stepTime(params_, i);
+            file_ << t;
+            if (i < params_.steps) file_ << ",";
+        }
+        file_ << std::endl;
+    }
+    
+    // Write paths first + 1, first + 2, ... (numbered from 1)
+    void write(int first, const std::vector<std::vector<double>>& block) {
+        for (std::size_t p = 0; p < block.size(); ++p) {
+            file_ << first + p + 1 << ",";
+            for (int j = 0; j <= params_.steps; ++j) {
+                file_ << block[p][j];
+                if (j < params_.steps) file_ << ",";
+            }
+            file_ << std::endl;
         }
-        all_paths_file << std::endl;
     }
     
-    all_paths_file.close();
+    // Close the paths file and save the time points to a separate file
+    void finish() {
+        file_.close();
+        std::ofstream time_file("time_points.csv");
+        for (int i = 0; i <= params_.steps; ++i) {
+            double t = stepTime(params_, i);
+            time_file << t << std::endl;
+        }
+        time_file.close();
+        
+        std::cout << "Results saved to CSV files for plotting." << std::endl;
+    }
     
-    // Save time points to a separate file
-    std::ofstream time_file("time_points.csv");
+private:
+    const SimulationParams& params_;
+    std::ofstream file_;
+};
+
+// Save simulation results to CSV files for plotting. PathSource is the full
+// path matrix or a CompressedPathStore (see forEachPathBlock).
+template <typename PathSource>
+void saveResultsToCSV(const PathSource& paths, const SimulationParams& params, const std::string& engine) {
+    // Save all paths to a single CSV file
+    PathsCsvWriter writer(params, engine);
+    forEachPathBlock(paths, [&](int first, const std::vector<std::vector<double>>& block) {
+        writer.write(first, block);
+    });
+    writer.finish();
+}
+
+// Save the first num_display paths for the HTML plot, each reduced to at most
+// plot_points points with LTTB so long paths stay light to render. Paths are
+// decimated in parallel; the output has one Path,Time,Price row per point.
+void saveDisplayPathsToCSV(const std::vector<std::vector<double>>& paths, const SimulationParams& params,
+                           int num_display, int plot_points, int num_threads) {
+    num_display = std::min<int>(num_display, paths.size());
+    std::vector<double> times(params.steps + 1);
     for (int i = 0; i <= params.steps; ++i) {
-        double t = i * (params.T / params.steps);
-        time_file << t << std::endl;
+        times[i] = stepTime(params, i);
     }
-    time_file.close();
     
-    std::cout << "Results saved to CSV files for plotting." << std::endl;
+    std::vector<std::vector<std::size_t>> kept(num_display);
+    parallelFor(num_display, num_threads, [&](int p, int) {
+        kept[p] = lttbIndices(times.data(), paths[p].data(), times.size(), plot_points);
+    });
+    
+    std::ofstream display_file("display_paths.csv");
+    display_file << "Path,Time,Price" << std::endl;
+    for (int p = 0; p < num_display; ++p) {
+        for (std::size_t i : kept[p]) {
+            display_file << p + 1 << "," << times[i] << "," << paths[p][i] << std::endl;
+        }
+    }
+    display_file.close();
+}
+
+// Answer P(S_T < K) and quantile queries from a terminal price index
+void printPriceQueries(const TerminalPriceIndex& index, const std::vector<double>& cdf_prices,
+                       const std::vector<double>& quantile_levels) {
+    std::cout << "\nTerminal price index: " << index.size() << " paths, $" << std::fixed << std::setprecision(2)
+              << index.min() << " - $" << index.max() << "\n";
+    for (double price : cdf_prices) {
+        std::cout << "P(S_T < $" << std::setprecision(2) << price << ") = " << std::setprecision(6)
+                  << index.probabilityBelow(price) << "\n";
+    }
+    for (double p : quantile_levels) {
+        std::cout << "Quantile " << std::defaultfloat << std::setprecision(6) << p * 100 << "%: $" << std::fixed << std::setprecision(2)
+                  << index.quantile(p) << "\n";
+    }
+    std::cout << std::defaultfloat;
+}
+
+// Exact quantiles of a sample file too large for memory: sort it out of core
+// into <path>.sorted and read each quantile's rank directly from the sorted file
+int runExternalQuantiles(const std::string& path, std::size_t memory_mb, int num_threads,
+                         std::vector<double> quantile_levels) {
+    if (quantile_levels.empty()) quantile_levels = {0.05, 0.5, 0.95};
+    std::string sorted_path = path + ".sorted";
+    std::string temp_dir = std::filesystem::path(sorted_path).parent_path().string();
+    try {
+        ExternalRadixSorter sorter(memory_mb * 1048576, num_threads, temp_dir.empty() ? "." : temp_dir);
+        auto sort_start = std::chrono::steady_clock::now();
+        std::uint64_t count = sorter.sort(path, sorted_path);
+        std::chrono::duration<double> sort_time = std::chrono::steady_clock::now() - sort_start;
+        std::cout << "Sorted " << count << " samples in " << std::fixed << std::setprecision(2)
+                  << sort_time.count() << " seconds with " << memory_mb << " MB of memory (" << sorter.bucketFiles()
+                  << " bucket files, partition depth " << sorter.depth() << ") into " << sorted_path << "\n";
+        if (count == 0) return 0;
+        
+        std::ifstream sorted(sorted_path, std::ios::binary);
+        for (double p : quantile_levels) {
+            double rank = std::floor(p * count);
+            std::uint64_t index =
+                rank <= 0.0 ? 0 : std::min<std::uint64_t>(static_cast<std::uint64_t>(rank), count - 1);
+            double value = 0.0;
+            sorted.seekg(index * sizeof(double));
+            sorted.read(reinterpret_cast<char*>(&value), sizeof(value));
+            if (!sorted) throw std::runtime_error("cannot read " + sorted_path);
+            std::cout << "Quantile " << std::defaultfloat << std::setprecision(6) << p * 100 << "%: "
+                      << std::setprecision(17) << value << "\n";
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// A rate as a percentage, or its range when it follows a term structure
+std::string describeRate(double rate, const TermStructure& curve) {
+    std::ostringstream text;
+    if (curve.empty()) {
+        text << rate * 100 << "%";
+    } else {
+        auto range = std::minmax_element(curve.values.begin(), curve.values.end());
+        text << *range.first * 100 << "% to " << *range.second * 100 << "% (term structure, "
+             << curve.times.size() << " knots)";
+    }
+    return text.str();
 }
 
 // Generate a simple HTML file with embedded JavaScript for plotting
-void generatePlotHTML(const SimulationParams& params) {
+void generatePlotHTML(const SimulationParams& params, const std::string& engine) {
     std::ofstream html_file("stock_price_plot.html");
     
     html_file << R"(
@@ -182,15 +1403,20 @@ void generatePlotHTML(const SimulationParams& params) {
         <div class="params">
             <h2>Simulation Parameters</h2>
             <p><strong>Initial Stock Price:</strong> $)" << params.S0 << R"(</p>
-            <p><strong>Expected Annual Return:</strong> )" << (params.mu * 100) << R"(%</p>
-            <p><strong>Annual Volatility:</strong> )" << (params.sigma * 100) << R"(%</p>
+            <p><strong>Expected Annual Return:</strong> )" << describeRate(params.mu, params.mu_curve) << R"(</p>
+            <p><strong>Annual Volatility:</strong> )" << describeRate(params.sigma, params.sigma_curve) << R"(</p>
             <p><strong>Time Period:</strong> )" << params.T << R"( years</p>
             <p><strong>Number of Paths:</strong> )" << params.num_paths << R"(</p>
+            <p><strong>Engine:</strong> )" << engine << R"(</p>
         </div>
         
         <div class="chart-container">
             <canvas id="stockChart"></canvas>
         </div>
+        
+        <div class="chart-container">
+            <canvas id="densityChart"></canvas>
+        </div>
     </div>
 
     <script>
@@ -214,24 +1440,24 @@ void generatePlotHTML(const SimulationParams& params) {
         // Main function to load data and create chart
         async function createChart() {
             try {
-                const pathsData = await loadCSV('stock_price_paths.csv');
+                // Display paths are already limited and decimated: rows of Path,Time,Price
+                const pathsData = await loadCSV('display_paths.csv');
                 
-                // Parse header for time points
-                const timePoints = pathsData[0].slice(1).map(parseFloat);
+                // Group the points of each path
+                const pathPoints = new Map();
+                for (const row of pathsData.slice(1)) {
+                    if (row.length !== 3) continue;
+                    if (!pathPoints.has(row[0])) pathPoints.set(row[0], []);
+                    pathPoints.get(row[0]).push({ x: parseFloat(row[1]), y: parseFloat(row[2]) });
+                }
                 
                 // Create datasets for each path
                 const datasets = [];
                 
-                // Limit to showing only 20 paths for better visualization
-                const maxPathsToShow = 20;
-                const pathsToShow = Math.min()" << params.num_paths << R"(, maxPathsToShow);
-                
-                for (let i = 1; i <= pathsToShow; i++) {
-                    const pathValues = pathsData[i].slice(1).map(parseFloat);
-                    
+                for (const [path, points] of pathPoints) {
                     datasets.push({
-                        label: `Path ${i}`,
-                        data: pathValues,
+                        label: `Path ${path}`,
+                        data: points,
                         borderColor: getRandomColor(),
                         backgroundColor: 'transparent',
                         borderWidth: 1,
@@ -244,7 +1470,6 @@ void generatePlotHTML(const SimulationParams& params) {
                 const stockChart = new Chart(ctx, {
                     type: 'line',
                     data: {
-                        labels: timePoints,
                         datasets: datasets
                     },
                     options: {
@@ -268,6 +1493,7 @@ void generatePlotHTML(const SimulationParams& params) {
                         },
                         scales: {
                             x: {
+                                type: 'linear',
                                 title: {
                                     display: true,
                                     text: 'Time (years)'
@@ -288,8 +1514,70 @@ void generatePlotHTML(const SimulationParams& params) {
             }
         }
 
-        // Call the function when the page loads
-        window.onload = createChart;
+        // Plot the kernel density estimate of the final price
+        async function createDensityChart() {
+            try {
+                const densityData = await loadCSV('terminal_density.csv');
+                const points = densityData.slice(1)
+                    .filter(row => row.length === 2)
+                    .map(row => ({ x: parseFloat(row[0]), y: parseFloat(row[1]) }));
+                
+                const ctx = document.getElementById('densityChart').getContext('2d');
+                new Chart(ctx, {
+                    type: 'line',
+                    data: {
+                        datasets: [{
+                            label: 'Density',
+                            data: points,
+                            borderColor: '#1f77b4',
+                            backgroundColor: 'rgba(31, 119, 180, 0.2)',
+                            fill: true,
+                            borderWidth: 1,
+                            pointRadius: 0
+                        }]
+                    },
+                    options: {
+                        responsive: true,
+                        maintainAspectRatio: false,
+                        plugins: {
+                            title: {
+                                display: true,
+                                text: 'Final Stock Price Density (Kernel Density Estimate)',
+                                font: {
+                                    size: 16
+                                }
+                            },
+                            legend: {
+                                display: false
+                            }
+                        },
+                        scales: {
+                            x: {
+                                type: 'linear',
+                                title: {
+                                    display: true,
+                                    text: 'Final Stock Price ($)'
+                                }
+                            },
+                            y: {
+                                title: {
+                                    display: true,
+                                    text: 'Density'
+                                }
+                            }
+                        }
+                    }
+                });
+            } catch (error) {
+                console.error('Error loading density:', error);
+            }
+        }
+
+        // Call the functions when the page loads
+        window.onload = () => {
+            createChart();
+            createDensityChart();
+        };
     </script>
 </body>
 </html>
@@ -301,9 +1589,903 @@ void generatePlotHTML(const SimulationParams& params) {
     std::cout << "Open this file in a web browser to view the simulation paths." << std::endl;
 }
 
-int main() {
+// Normalized terminal shocks cached for streaming re-simulation. Under GBM the
+// final price depends on the shocks only through their sum, so each path keeps
+// one standardized value z = sum(Z_i) / sqrt(steps). The values are sorted once
+// so that percentiles, min and max can be read off directly whenever S0 or
+// sigma change (the final price is monotonic in z).
+struct ShockCache {
+    std::vector<double> z_sorted;
+    // exp(b*z) moments, reused while the volatility term b is unchanged
+    double cached_b = std::nan("");
+    double mean_exp_bz = 0.0;
+    double mean_exp_2bz = 0.0;
+};
+
+ShockCache buildShockCache(const SimulationParams& params, NormalStream& normals) {
+    ShockCache cache;
+    cache.z_sorted.resize(params.num_paths);
+    normals.fill(cache.z_sorted.data(), cache.z_sorted.size());
+    std::sort(cache.z_sorted.begin(), cache.z_sorted.end());
+    return cache;
+}
+
+// Summary of the forecast distribution of the final stock price
+struct ForecastSummary {
+    double mean;
+    double std_dev;
+    double min_price;
+    double max_price;
+    double percentile_5;
+    double percentile_95;
+};
+
+// Recompute the final price distribution for the current S0 and sigma using the
+// cached shocks. Costs O(1) when only S0 changed and O(num_paths) when sigma did.
+ForecastSummary refreshForecast(ShockCache& cache, const SimulationParams& params) {
+    int num_paths = cache.z_sorted.size();
+    double a = (params.mu - 0.5 * params.sigma * params.sigma) * params.T;
+    double b = params.sigma * std::sqrt(params.T);
+    
+    if (b != cache.cached_b) {
+        double sum1 = 0.0;
+        double sum2 = 0.0;
+        for (double z : cache.z_sorted) {
+            double e = std::exp(b * z);
+            sum1 += e;
+            sum2 += e * e;
+        }
+        cache.cached_b = b;
+        cache.mean_exp_bz = sum1 / num_paths;
+        cache.mean_exp_2bz = sum2 / num_paths;
+    }
+    
+    double scale = params.S0 * std::exp(a);
+    auto priceAt = [&](int index) { return scale * std::exp(b * cache.z_sorted[index]); };
+    
+    ForecastSummary summary;
+    summary.mean = scale * cache.mean_exp_bz;
+    double second_moment = scale * scale * cache.mean_exp_2bz;
+    summary.std_dev = std::sqrt(std::max(0.0, second_moment - summary.mean * summary.mean));
+    summary.min_price = priceAt(0);
+    summary.max_price = priceAt(num_paths - 1);
+    summary.percentile_5 = priceAt(static_cast<int>(0.05 * num_paths));
+    summary.percentile_95 = priceAt(static_cast<int>(0.95 * num_paths));
+    return summary;
+}
+
+// Options for streaming mode
+struct StreamOptions {
+    std::string tick_source;       // File or named pipe to read ticks from
+    double ewma_lambda = 0.0;      // EWMA decay for volatility updates (0 = keep sigma fixed)
+    double ticks_per_year = 252.0; // Used to annualize the EWMA variance
+};
+
+// Tail the tick source, update S0 (and optionally sigma) on every tick and print
+// the refreshed forecast together with the update latency
+int runStreamingSimulation(SimulationParams params, const StreamOptions& options, const EngineConfig& config) {
+    TickStream ticks(options.tick_source);
+    if (!ticks.isOpen()) {
+        std::cerr << "Error: cannot open tick source " << options.tick_source << std::endl;
+        return 1;
+    }
+    
+    ShockCache cache = buildShockCache(params, *blockGenerator(config, 0));
+    
+    // Per-tick variance, seeded from the entered annual volatility
+    double tick_variance = params.sigma * params.sigma / options.ticks_per_year;
+    double last_price = 0.0;
+    long tick_count = 0;
+    
+    std::cout << "\nStreaming forecasts from " << options.tick_source << " (" << params.num_paths
+              << " cached shocks)...\n";
+    
+    double price;
+    while (ticks.next(price)) {
+        auto start_time = std::chrono::steady_clock::now();
+        ++tick_count;
+        
+        if (options.ewma_lambda > 0.0 && last_price > 0.0) {
+            double r = std::log(price / last_price);
+            tick_variance = options.ewma_lambda * tick_variance + (1.0 - options.ewma_lambda) * r * r;
+            params.sigma = std::sqrt(tick_variance * options.ticks_per_year);
+        }
+        last_price = price;
+        params.S0 = price;
+        
+        ForecastSummary f = refreshForecast(cache, params);
+        
+        auto end_time = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> latency = end_time - start_time;
+        
+        std::cout << "Tick " << tick_count << std::fixed << std::setprecision(2)
+                  << ": S0=$" << params.S0
+                  << " sigma=" << params.sigma * 100 << "%"
+                  << " | Mean $" << f.mean
+                  << " SD $" << f.std_dev
+                  << " 5th $" << f.percentile_5
+                  << " 95th $" << f.percentile_95
+                  << " | " << std::setprecision(3) << latency.count() << " ms" << std::endl;
+    }
+    
+    std::cout << "Tick stream ended after " << tick_count << " ticks.\n";
+    return 0;
+}
+
+// Engine settings found by the autotuner, keyed by machine and problem size.
+// Problem sizes are bucketed by powers of two of steps and num_paths so that
+// one tuning run covers similar jobs.
+struct TunedProfileKey {
+    int hardware_threads;
+    int steps_bucket;
+    int paths_bucket;
+    
+    bool operator==(const TunedProfileKey& other) const {
+        return hardware_threads == other.hardware_threads && steps_bucket == other.steps_bucket &&
+               paths_bucket == other.paths_bucket;
+    }
+};
+
+TunedProfileKey makeProfileKey(const SimulationParams& params) {
+    return {static_cast<int>(std::max(1u, std::thread::hardware_concurrency())),
+            static_cast<int>(std::log2(std::max(1, params.steps))),
+            static_cast<int>(std::log2(std::max(1, params.num_paths)))};
+}
+
+const char* layoutName(PathLayout layout) {
+    return layout == PathLayout::StepMajor ? "step" : "path";
+}
+
+const char* rngName(RngEngine engine) {
+    switch (engine) {
+        case RngEngine::Xoshiro256: return "xoshiro256";
+        case RngEngine::Pcg64: return "pcg64";
+        case RngEngine::Philox4x32: return "philox";
+        default: return "mt19937";
+    }
+}
+
+// Accuracy and throughput of every exp tier against std::exp on one thread.
+// Accuracy is the largest relative error over typical log-returns (|x| <= 1)
+// and over the full range of normal results (|x| <= 708).
+void benchmarkExpTiers() {
+    const ExpTier tiers[] = {ExpTier::Exact, ExpTier::Tier1e15, ExpTier::Tier1e10, ExpTier::Tier1e6};
+    const int kSamples = 1 << 20;
+    const int kBatch = 4096;  // Cache-resident, like a step-major block
+    std::mt19937_64 gen(1);
+    std::uniform_real_distribution<double> small(-1.0, 1.0), wide(-708.0, 708.0);
+    std::vector<double> small_x(kSamples), wide_x(kSamples);
+    for (int i = 0; i < kSamples; ++i) {
+        small_x[i] = small(gen);
+        wide_x[i] = wide(gen);
+    }
+    
+    auto maxRelativeError = [](ExpTier tier, const std::vector<double>& x) {
+        std::vector<double> y(x);
+        expInPlace(tier, y.data(), static_cast<int>(y.size()));
+        double worst = 0.0;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            double exact = std::exp(x[i]);
+            worst = std::max(worst, std::fabs(y[i] - exact) / exact);
+        }
+        return worst;
+    };
+    auto throughput = [&](ExpTier tier) {
+        std::vector<double> batch(kBatch);
+        auto start = std::chrono::steady_clock::now();
+        for (int first = 0; first < kSamples; first += kBatch) {
+            std::copy(small_x.begin() + first, small_x.begin() + first + kBatch, batch.begin());
+            expInPlace(tier, batch.data(), kBatch);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return kSamples / elapsed.count();
+    };
+    
+    double exact_rate = throughput(ExpTier::Exact);
+    std::cout << "\nexp accuracy tiers (1 thread):\n";
+    std::cout << std::left << std::setw(8) << "Tier" << std::right << std::setw(16) << "Max rel. error"
+              << std::setw(16) << "(|x| <= 708)" << std::setw(12) << "Mexp/sec" << std::setw(10) << "Speedup"
+              << "\n";
+    for (ExpTier tier : tiers) {
+        double rate = tier == ExpTier::Exact ? exact_rate : throughput(tier);
+        std::cout << std::left << std::setw(8) << expTierName(tier) << std::right << std::scientific
+                  << std::setprecision(2) << std::setw(16) << maxRelativeError(tier, small_x) << std::setw(16)
+                  << maxRelativeError(tier, wide_x) << std::fixed << std::setprecision(1) << std::setw(12)
+                  << rate / 1e6 << std::setw(9) << rate / exact_rate << "x\n";
+    }
+}
+
+// Throughput of every engine on one thread: raw output in bytes/sec through
+// the bulk fill, and standard normal variates/sec as the kernels draw them
+void benchmarkRngEngines(std::uint64_t seed) {
+    const std::size_t kWords = std::size_t(1) << 22;
+    const std::size_t kNormals = std::size_t(1) << 22;
+    const RngEngine engines[] = {RngEngine::Mt19937, RngEngine::Xoshiro256, RngEngine::Pcg64,
+                                 RngEngine::Philox4x32};
+    [[maybe_unused]] static volatile double sink;
+    
+    std::cout << "\nRNG engine benchmark (1 thread):\n";
+    std::cout << std::left << std::setw(12) << "Engine" << std::right << std::setw(14) << "MB/sec"
+              << std::setw(18) << "Mnormals/sec" << "\n";
+    for (RngEngine engine : engines) {
+        double checksum = 0.0;
+        double bytes_per_sec = withEngine(engine, seed, 0, [&](auto e) {
+            using Word = typename decltype(e)::result_type;
+            std::vector<Word> words(kWords);
+            e.fill(words.data(), words.size());  // Warm-up
+            auto start = std::chrono::steady_clock::now();
+            e.fill(words.data(), words.size());
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            checksum += static_cast<double>(words[kWords / 2]);
+            return kWords * sizeof(Word) / elapsed.count();
+        });
+        
+        std::unique_ptr<NormalStream> normals = makeNormalStream(engine, seed, 1);
+        std::vector<double> z(kNormals);
+        normals->fill(z.data(), z.size());  // Warm-up
+        auto start = std::chrono::steady_clock::now();
+        normals->fill(z.data(), z.size());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        checksum += z[kNormals / 2];
+        
+        std::cout << std::left << std::setw(12) << rngName(engine) << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(14) << bytes_per_sec / 1e6 << std::setw(18)
+                  << kNormals / elapsed.count() / 1e6 << "\n";
+        sink = checksum;  // Keep the generated values observable
+    }
+}
+
+const char* modelName(SdeModel model) {
+    switch (model) {
+        case SdeModel::OrnsteinUhlenbeck: return "ou";
+        case SdeModel::Cir: return "cir";
+        case SdeModel::Cev: return "cev";
+        default: return "gbm";
+    }
+}
+
+const char* schemeName(SdeScheme scheme) {
+    switch (scheme) {
+        case SdeScheme::Euler: return "euler";
+        case SdeScheme::Milstein: return "milstein";
+        default: return "exact";
+    }
+}
+
+// What generated the paths, recorded in the output files so results can be
+// traced to the kernel and the accuracy of its exponential
+std::string describeEngine(const SimulationParams& params, const EngineConfig& config) {
+    std::ostringstream text;
+    if (params.model.scheme != SdeScheme::Exact) {
+        text << "model " << modelName(params.model.model) << ", " << schemeName(params.model.scheme) << " scheme";
+    } else if (config.layout == PathLayout::StepMajor) {
+        StepKernel kernel = selectStepKernel(config.isa, config.exp_tier);
+        text << "step kernel " << kernel.name << ", exp tier " << expTierName(kernel.tier);
+    } else {
+        text << "path-major, exp tier " << expTierName(config.exp_tier);
+    }
+    return text.str();
+}
+
+// Profile file format, one entry per line:
+//   <hardware_threads> <steps_bucket> <paths_bucket> <threads> <path|step> <block_size> <paths_per_sec>
+// Lines starting with '#' are comments. With threads_only, only the thread
+// count is taken: layout and block size change the order of the random draws
+// and with it the results of a fixed seed.
+bool loadTunedConfig(const std::string& profile_path, const SimulationParams& params, EngineConfig& config,
+                     bool threads_only = false) {
+    std::ifstream profile(profile_path);
+    TunedProfileKey key = makeProfileKey(params);
+    std::string line;
+    while (std::getline(profile, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        TunedProfileKey entry;
+        int threads, block_size;
+        std::string layout;
+        if (!(fields >> entry.hardware_threads >> entry.steps_bucket >> entry.paths_bucket >> threads >> layout
+                     >> block_size)) {
+            continue;
+        }
+        if (entry == key) {
+            config.num_threads = threads;
+            if (!threads_only) {
+                config.layout = (layout == "path") ? PathLayout::PathMajor : PathLayout::StepMajor;
+                config.block_size = block_size;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Replace (or add) the entry for this machine and problem size
+void saveTunedConfig(const std::string& profile_path, const SimulationParams& params, const EngineConfig& config,
+                     double paths_per_sec) {
+    TunedProfileKey key = makeProfileKey(params);
+    std::vector<std::string> lines;
+    {
+        std::ifstream profile(profile_path);
+        std::string line;
+        while (std::getline(profile, line)) {
+            std::istringstream fields(line);
+            TunedProfileKey entry;
+            if (line[0] != '#' && fields >> entry.hardware_threads >> entry.steps_bucket >> entry.paths_bucket &&
+                entry == key) {
+                continue;
+            }
+            lines.push_back(line);
+        }
+    }
+    if (lines.empty()) {
+        lines.push_back("# hardware_threads steps_bucket paths_bucket threads layout block_size paths_per_sec");
+    }
+    
+    std::ostringstream entry;
+    entry << key.hardware_threads << " " << key.steps_bucket << " " << key.paths_bucket << " "
+          << config.num_threads << " " << layoutName(config.layout) << " " << config.block_size << " "
+          << static_cast<long long>(paths_per_sec);
+    lines.push_back(entry.str());
+    
+    std::ofstream profile(profile_path);
+    for (const std::string& line : lines) {
+        profile << line << std::endl;
+    }
+}
+
+// Benchmark a small grid of thread counts, layouts and block sizes on a
+// reduced number of paths and return the fastest configuration
+EngineConfig autotuneEngine(const SimulationParams& params, const EngineConfig& base_config, double& best_rate) {
+    int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> thread_counts = {1};
+    if (hardware_threads >= 4) thread_counts.push_back(hardware_threads / 2);
+    if (hardware_threads > 1) thread_counts.push_back(hardware_threads);
+    const int block_sizes[] = {64, 128, 256, 512, 1024};
+    
+    // Enough work to time reliably and to keep every thread busy
+    SimulationParams bench_params = params;
+    bench_params.num_paths = std::min(params.num_paths,
+                                      std::max(kPathsPerBlock * hardware_threads, 4000000 / std::max(1, params.steps)));
+    
+    std::vector<EngineConfig> candidates;
+    for (int threads : thread_counts) {
+        EngineConfig candidate = base_config;
+        candidate.show_progress = false;
+        candidate.num_threads = threads;
+        candidate.layout = PathLayout::PathMajor;
+        candidates.push_back(candidate);
+        candidate.layout = PathLayout::StepMajor;
+        for (int block_size : block_sizes) {
+            candidate.block_size = block_size;
+            candidates.push_back(candidate);
+        }
+    }
+    
+    std::cout << "\nAutotuning on " << bench_params.num_paths << " paths x " << params.steps << " steps...\n";
+    std::cout << "Threads  Layout  Block  Paths/sec\n";
+    EngineConfig best = base_config;
+    best_rate = 0.0;
+    for (const EngineConfig& candidate : candidates) {
+        // Best of two runs to filter out noise
+        double rate = 0.0;
+        for (int run = 0; run < 2; ++run) {
+            auto start_time = std::chrono::steady_clock::now();
+            runMonteCarloSimulation(bench_params, candidate);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+            rate = std::max(rate, bench_params.num_paths / elapsed.count());
+        }
+        std::cout << std::setw(7) << candidate.num_threads << "  " << std::setw(6) << layoutName(candidate.layout)
+                  << "  " << std::setw(5);
+        if (candidate.layout == PathLayout::StepMajor) {
+            std::cout << candidate.block_size;
+        } else {
+            std::cout << "-";
+        }
+        std::cout << "  " << static_cast<long long>(rate) << std::endl;
+        if (rate > best_rate) {
+            best_rate = rate;
+            best = candidate;
+            best.show_progress = base_config.show_progress;
+        }
+    }
+    return best;
+}
+
+// Bump whenever a change to the engine alters results for the same inputs, so
+// stale cache entries are no longer matched
+const char* kEngineVersion = "6";
+
+// Canonical description of everything that determines the printed statistics.
+// Doubles are written in hexfloat so that the key is exact.
+std::string resultCacheKey(const SimulationParams& params, const EngineConfig& config, int compress_bits,
+                           double confidence, bool approx_percentiles) {
+    std::ostringstream key;
+    key << std::hexfloat << "engine=" << kEngineVersion << ";S0=" << params.S0 << ";mu=" << params.mu
+        << ";sigma=" << params.sigma << ";T=" << params.T << ";steps=" << params.steps
+        << ";paths=" << params.num_paths << ";seed=" << config.seed << ";rng=" << rngName(config.rng)
+        << ";exp=" << expTierName(config.exp_tier) << ";layout=" << layoutName(config.layout);
+    if (config.layout == PathLayout::StepMajor) {
+        // Block size sets the order random numbers are drawn in; kernel variants may contract to FMA
+        key << ";block=" << config.block_size << ";kernel=" << selectStepKernel(config.isa, config.exp_tier).name;
+    }
+    auto appendCurve = [&](const char* name, const TermStructure& curve) {
+        if (curve.empty()) return;
+        key << ";" << name << "=" << (curve.interpolation == TermStructure::Interpolation::Linear ? "linear" : "step");
+        for (std::size_t k = 0; k < curve.times.size(); ++k) {
+            key << "," << curve.times[k] << ":" << curve.values[k];
+        }
+    };
+    if (params.model.scheme != SdeScheme::Exact) {
+        key << ";model=" << modelName(params.model.model) << ";scheme=" << schemeName(params.model.scheme)
+            << ";kappa=" << params.model.kappa << ";theta=" << params.model.theta << ";beta=" << params.model.beta;
+    }
+    appendCurve("mu_curve", params.mu_curve);
+    appendCurve("sigma_curve", params.sigma_curve);
+    if (!params.time_grid.empty()) {
+        key << ";grid";
+        for (double t : params.time_grid) key << "," << t;
+    }
+    key << ";compress=" << compress_bits << ";confidence=" << confidence;
+    if (approx_percentiles) {
+        key << ";histogram=" << config.histogram_bins;
+    }
+    return key.str();
+}
+
+std::string serializeStatistics(const FinalPriceStatistics& stats) {
+    std::ostringstream out;
+    out << std::setprecision(17);
+    out << "num_paths " << stats.num_paths << "\n"
+        << "confidence " << stats.confidence << "\n"
+        << "histogram_bins " << stats.histogram_bins << "\n"
+        << "bin_width " << stats.bin_width << "\n"
+        << "min_price " << stats.min_price << "\n"
+        << "max_price " << stats.max_price << "\n";
+    auto writeEstimate = [&](const char* name, const Estimate& e) {
+        out << name << " " << e.value << " " << e.std_error << " " << e.ci_low << " " << e.ci_high << "\n";
+    };
+    writeEstimate("mean", stats.mean);
+    writeEstimate("std_dev", stats.std_dev);
+    writeEstimate("percentile_5", stats.percentile_5);
+    writeEstimate("percentile_95", stats.percentile_95);
+    return out.str();
+}
+
+bool parseStatistics(const std::string& text, FinalPriceStatistics& stats) {
+    std::istringstream in(text);
+    auto readEstimate = [&](const char* name, Estimate& e) {
+        std::string label;
+        return in >> label >> e.value >> e.std_error >> e.ci_low >> e.ci_high && label == name;
+    };
+    std::string label;
+    return in >> label >> stats.num_paths >> label >> stats.confidence >> label >> stats.histogram_bins
+              >> label >> stats.bin_width >> label >> stats.min_price >> label >> stats.max_price &&
+           readEstimate("mean", stats.mean) && readEstimate("std_dev", stats.std_dev) &&
+           readEstimate("percentile_5", stats.percentile_5) && readEstimate("percentile_95", stats.percentile_95);
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --stream <path>          Tail a tick file or pipe and re-simulate on each price\n"
+              << "  --ewma-lambda <lambda>   Update volatility from ticks with EWMA decay lambda\n"
+              << "  --ticks-per-year <n>     Ticks per year for annualizing EWMA volatility (default 252)\n"
+              << "  --mu-curve <file>        Time-dependent drift from \"time,mu\" lines (overrides entered mu)\n"
+              << "  --sigma-curve <file>     Time-dependent volatility from \"time,sigma\" lines\n"
+              << "  --curve-interp <mode>    Term structure interpolation: step (default) or linear\n"
+              << "  --time-grid <file>       Simulate on explicit times (years) or observation dates (YYYY-MM-DD)\n"
+              << "  --calendar <start> <end> Daily steps over the business days between two dates\n"
+              << "  --holidays <file>        Holidays (YYYY-MM-DD per line) excluded from business days\n"
+              << "  --business-days          Measure dates in the time grid in business days / 252\n"
+              << "  --model <name>           Process: gbm (default), ou, cir or cev\n"
+              << "  --scheme <name>          Discretization: exact (GBM only), euler or milstein\n"
+              << "  --kappa <k>              Mean-reversion speed for ou/cir (default 1)\n"
+              << "  --theta <level>          Mean-reversion level for ou/cir (default: initial price)\n"
+              << "  --beta <b>               CEV elasticity (default 0.5)\n"
+              << "  --american <put|call>    Price an American option on the paths (Longstaff-Schwartz)\n"
+              << "  --barrier <level>        Price a barrier option with Brownian-bridge monitoring\n"
+              << "  --barrier-type <type>    up-out, up-in, down-out or down-in (default: out, side from level)\n"
+              << "  --barrier-payoff <type>  call (default) or put payoff of the barrier option\n"
+              << "  --strike <K>             Option strike (default: initial price)\n"
+              << "  --rate <r>               Discount rate (default: the expected return)\n"
+              << "  --exercise-dates <n>     Equally spaced exercise dates (default: every step, at most 50)\n"
+              << "  --basis-degree <d>       Degree of the regression polynomial (default 3)\n"
+              << "  --path-metrics           Track maximum drawdown of every path\n"
+              << "  --passage-level <L>      Also track the first time each path reaches the price L\n"
+              << "  --rng <engine>           Random engine: mt19937 (default), xoshiro256, pcg64 or philox\n"
+              << "  --exp-tier <tier>        exp accuracy in the GBM kernels: exact (default), 1e-15, 1e-10 or 1e-6\n"
+              << "  --exp-benchmark          Report accuracy and speed of every exp tier and exit\n"
+              << "  --rng-benchmark          Measure the throughput of every random engine and exit\n"
+              << "  --shm <name>             Publish statistics and paths in POSIX shared memory segment <name>\n"
+              << "  --shm-stats-only         Publish only the statistics with --shm\n"
+              << "  --exposure <call|put>    Exposure profile of a European option by nested simulation\n"
+              << "  --exposure-dates <n>     Equally spaced exposure dates from t = 0 (default 20)\n"
+              << "  --inner-paths <n>        Inner simulations per outer path and date (default 2000)\n"
+              << "  --threads <n>            Worker threads (default: all hardware threads)\n"
+              << "  --seed <n>               Base random seed (default: random)\n"
+              << "  --histogram-bins <n>     Bins in the final price histogram (default 4096)\n"
+              << "  --layout <path|step>     Path-major or step-major (lockstep) generation (default step)\n"
+              << "  --block-size <n>         Paths advanced together in step-major layout (default 256)\n"
+              << "  --isa <variant>          Step kernel: auto, generic, avx2 or avx512 (default auto)\n"
+              << "  --progress               Show progress, throughput and ETA on stderr\n"
+              << "  --kde-points <n>         Grid points of the final price density estimate (default 2048)\n"
+              << "  --display-paths <n>      Paths shown in the HTML plot (default 20)\n"
+              << "  --plot-points <n>        Points per plotted path after LTTB decimation (default 500)\n"
+              << "  --compress-bits <b>      Keep paths as b-bit quantized log-returns (2-32, e.g. 8 or 16)\n"
+              << "  --price-index <file>     Save the sorted final prices for later CDF/quantile queries\n"
+              << "  --query-index <file>     Answer --cdf/--quantile queries from a saved index and exit\n"
+              << "  --cdf <K>                Report P(S_T < K) (repeatable)\n"
+              << "  --quantile <p>           Report the final price quantile at level p in [0, 1] (repeatable)\n"
+              << "  --sort-samples <file>    Exact --quantile values of a raw file of doubles, sorted out of core; exit\n"
+              << "  --sort-memory <MB>       Memory for --sort-samples (default 1024)\n"
+              << "  --lazy                   Write paths block by block as they are generated instead of keeping them\n"
+              << "  --approx-percentiles     Read percentiles from the histogram instead of sorting\n"
+              << "  --confidence <level>     Confidence level of reported intervals (default 0.95)\n"
+              << "  --target-half-width <x>  Report the paths needed for CIs of +-$x on each statistic\n"
+              << "  --autotune               Benchmark engine settings, save the best to the profile and use them\n"
+              << "  --profile <path>         Autotune profile file (default monte_carlo_profile.txt)\n"
+              << "  --use-profile            Apply the profile's layout and block size even with --seed\n"
+              << "  --cache                  Reuse statistics of identical earlier runs (requires --seed)\n"
+              << "  --cache-dir <path>       Result cache directory (default .mc_cache)\n"
+              << "  --cache-paths            Also store the paths in the cache as raw doubles\n"
+              << "  --help                   Show this message\n";
+}
+
+int main(int argc, char* argv[]) {
+    // Parse command-line options
+    StreamOptions stream_options;
+    EngineConfig config;
+    config.num_threads = std::max(1u, std::thread::hardware_concurrency());
+    config.seed = (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+    bool approx_percentiles = false;
+    double confidence = 0.95;
+    double target_half_width = 0.0;
+    bool autotune = false;
+    int kde_points = 2048;
+    int display_paths = 20;
+    int plot_points = 500;
+    int compress_bits = 0;
+    bool seed_given = false;
+    std::string mu_curve_path;
+    std::string sigma_curve_path;
+    TermStructure::Interpolation curve_interpolation = TermStructure::Interpolation::Step;
+    std::string time_grid_path;
+    std::string calendar_start, calendar_end;
+    std::string holidays_path;
+    bool business_days = false;
+    ModelSpec model;
+    bool theta_given = false;
+    bool price_american = false;
+    AmericanOption american;
+    bool rng_benchmark = false;
+    bool exp_benchmark = false;
+    bool exposure = false;
+    VanillaOption exposure_option;
+    int exposure_dates = 20;
+    int inner_paths = 2000;
+    std::string shm_name;
+    bool shm_paths = true;
+    bool path_metrics = false;
+    double passage_level = 0.0;
+    bool price_barrier = false;
+    BarrierOption barrier;
+    bool barrier_type_given = false;
+    double strike = 0.0;
+    double rate = 0.0;
+    bool strike_given = false;
+    bool rate_given = false;
+    int exercise_dates = 50;
+    bool use_cache = false;
+    bool cache_paths = false;
+    bool lazy = false;
+    std::string price_index_path;
+    std::string query_index_path;
+    std::vector<double> cdf_prices;
+    std::vector<double> quantile_levels;
+    std::string sort_samples_path;
+    std::size_t sort_memory_mb = 1024;
+    std::string cache_dir = ".mc_cache";
+    bool engine_overridden = false;
+    bool use_full_profile = false;
+    std::string profile_path = "monte_carlo_profile.txt";
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (arg == "--stream" && has_value) {
+                stream_options.tick_source = argv[++i];
+            } else if (arg == "--ewma-lambda" && has_value) {
+                stream_options.ewma_lambda = std::stod(argv[++i]);
+                if (!(stream_options.ewma_lambda > 0.0 && stream_options.ewma_lambda < 1.0)) {
+                    // Outside (0, 1) the weights of the variance update turn negative or explode
+                    std::cerr << "Error: --ewma-lambda must be between 0 and 1 (exclusive)\n";
+                    return 1;
+                }
+            } else if (arg == "--ticks-per-year" && has_value) {
+                stream_options.ticks_per_year = std::stod(argv[++i]);
+            } else if (arg == "--mu-curve" && has_value) {
+                mu_curve_path = argv[++i];
+            } else if (arg == "--sigma-curve" && has_value) {
+                sigma_curve_path = argv[++i];
+            } else if (arg == "--curve-interp" && has_value) {
+                std::string mode = argv[++i];
+                if (mode != "step" && mode != "linear") throw std::invalid_argument(mode);
+                curve_interpolation = mode == "linear" ? TermStructure::Interpolation::Linear
+                                                       : TermStructure::Interpolation::Step;
+            } else if (arg == "--time-grid" && has_value) {
+                time_grid_path = argv[++i];
+            } else if (arg == "--calendar" && i + 2 < argc) {
+                calendar_start = argv[++i];
+                calendar_end = argv[++i];
+            } else if (arg == "--holidays" && has_value) {
+                holidays_path = argv[++i];
+            } else if (arg == "--business-days") {
+                business_days = true;
+            } else if (arg == "--model" && has_value) {
+                std::string name = argv[++i];
+                if (name == "gbm") model.model = SdeModel::Gbm;
+                else if (name == "ou") model.model = SdeModel::OrnsteinUhlenbeck;
+                else if (name == "cir") model.model = SdeModel::Cir;
+                else if (name == "cev") model.model = SdeModel::Cev;
+                else throw std::invalid_argument(name);
+            } else if (arg == "--scheme" && has_value) {
+                std::string name = argv[++i];
+                if (name == "exact") model.scheme = SdeScheme::Exact;
+                else if (name == "euler") model.scheme = SdeScheme::Euler;
+                else if (name == "milstein") model.scheme = SdeScheme::Milstein;
+                else throw std::invalid_argument(name);
+            } else if (arg == "--kappa" && has_value) {
+                model.kappa = std::stod(argv[++i]);
+            } else if (arg == "--theta" && has_value) {
+                model.theta = std::stod(argv[++i]);
+                theta_given = true;
+            } else if (arg == "--beta" && has_value) {
+                model.beta = std::stod(argv[++i]);
+            } else if (arg == "--american" && has_value) {
+                std::string type = argv[++i];
+                if (type != "put" && type != "call") throw std::invalid_argument(type);
+                price_american = true;
+                american.is_call = type == "call";
+            } else if (arg == "--path-metrics") {
+                path_metrics = true;
+            } else if (arg == "--passage-level" && has_value) {
+                passage_level = std::stod(argv[++i]);
+                if (!(passage_level > 0.0)) throw std::invalid_argument("passage-level");
+                path_metrics = true;
+            } else if (arg == "--barrier" && has_value) {
+                barrier.level = std::stod(argv[++i]);
+                if (!(barrier.level > 0.0)) throw std::invalid_argument("barrier");
+                price_barrier = true;
+            } else if (arg == "--barrier-type" && has_value) {
+                std::string type = argv[++i];
+                if (type == "up-out") barrier.type = BarrierOption::Type::UpOut;
+                else if (type == "up-in") barrier.type = BarrierOption::Type::UpIn;
+                else if (type == "down-out") barrier.type = BarrierOption::Type::DownOut;
+                else if (type == "down-in") barrier.type = BarrierOption::Type::DownIn;
+                else throw std::invalid_argument(type);
+                barrier_type_given = true;
+            } else if (arg == "--barrier-payoff" && has_value) {
+                std::string type = argv[++i];
+                if (type != "put" && type != "call") throw std::invalid_argument(type);
+                barrier.is_call = type == "call";
+            } else if (arg == "--strike" && has_value) {
+                strike = std::stod(argv[++i]);
+                strike_given = true;
+            } else if (arg == "--rate" && has_value) {
+                rate = std::stod(argv[++i]);
+                rate_given = true;
+            } else if (arg == "--exercise-dates" && has_value) {
+                exercise_dates = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--basis-degree" && has_value) {
+                american.basis_degree = std::stoi(argv[++i]);
+                if (american.basis_degree < 0 || american.basis_degree > 8) {
+                    throw std::invalid_argument("basis-degree");
+                }
+            } else if (arg == "--rng" && has_value) {
+                std::string name = argv[++i];
+                if (name == "mt19937") config.rng = RngEngine::Mt19937;
+                else if (name == "xoshiro256") config.rng = RngEngine::Xoshiro256;
+                else if (name == "pcg64") config.rng = RngEngine::Pcg64;
+                else if (name == "philox") config.rng = RngEngine::Philox4x32;
+                else throw std::invalid_argument(name);
+            } else if (arg == "--shm" && has_value) {
+                shm_name = argv[++i];
+                if (shm_name.empty() || shm_name[0] != '/') shm_name = "/" + shm_name;
+            } else if (arg == "--shm-stats-only") {
+                shm_paths = false;
+            } else if (arg == "--exposure" && has_value) {
+                std::string type = argv[++i];
+                if (type != "put" && type != "call") throw std::invalid_argument(type);
+                exposure = true;
+                exposure_option.is_call = type == "call";
+            } else if (arg == "--exposure-dates" && has_value) {
+                exposure_dates = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--inner-paths" && has_value) {
+                inner_paths = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--exp-tier" && has_value) {
+                std::string name = argv[++i];
+                if (name == "exact") config.exp_tier = ExpTier::Exact;
+                else if (name == "1e-15") config.exp_tier = ExpTier::Tier1e15;
+                else if (name == "1e-10") config.exp_tier = ExpTier::Tier1e10;
+                else if (name == "1e-6") config.exp_tier = ExpTier::Tier1e6;
+                else throw std::invalid_argument(name);
+            } else if (arg == "--exp-benchmark") {
+                exp_benchmark = true;
+            } else if (arg == "--rng-benchmark") {
+                rng_benchmark = true;
+            } else if (arg == "--threads" && has_value) {
+                config.num_threads = std::max(1, std::stoi(argv[++i]));
+                engine_overridden = true;
+            } else if (arg == "--seed" && has_value) {
+                config.seed = std::stoull(argv[++i]);
+                seed_given = true;
+            } else if (arg == "--histogram-bins" && has_value) {
+                config.histogram_bins = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--layout" && has_value) {
+                std::string layout = argv[++i];
+                if (layout != "path" && layout != "step") throw std::invalid_argument(layout);
+                config.layout = (layout == "path") ? PathLayout::PathMajor : PathLayout::StepMajor;
+                engine_overridden = true;
+            } else if (arg == "--block-size" && has_value) {
+                config.block_size = std::max(1, std::stoi(argv[++i]));
+                engine_overridden = true;
+            } else if (arg == "--isa" && has_value) {
+                std::string isa = argv[++i];
+                if (isa == "auto") config.isa = KernelIsa::Auto;
+                else if (isa == "generic") config.isa = KernelIsa::Generic;
+                else if (isa == "avx2") config.isa = KernelIsa::Avx2;
+                else if (isa == "avx512") config.isa = KernelIsa::Avx512;
+                else throw std::invalid_argument(isa);
+            } else if (arg == "--confidence" && has_value) {
+                confidence = std::stod(argv[++i]);
+                if (!(confidence > 0.0 && confidence < 1.0)) throw std::invalid_argument("confidence");
+            } else if (arg == "--target-half-width" && has_value) {
+                target_half_width = std::stod(argv[++i]);
+            } else if (arg == "--autotune") {
+                autotune = true;
+            } else if (arg == "--profile" && has_value) {
+                profile_path = argv[++i];
+            } else if (arg == "--use-profile") {
+                use_full_profile = true;
+            } else if (arg == "--progress") {
+                config.show_progress = true;
+            } else if (arg == "--kde-points" && has_value) {
+                kde_points = std::max(2, std::stoi(argv[++i]));
+            } else if (arg == "--display-paths" && has_value) {
+                display_paths = std::max(0, std::stoi(argv[++i]));
+            } else if (arg == "--plot-points" && has_value) {
+                plot_points = std::max(3, std::stoi(argv[++i]));
+            } else if (arg == "--compress-bits" && has_value) {
+                compress_bits = std::stoi(argv[++i]);
+                if (compress_bits < 2 || compress_bits > 32) throw std::invalid_argument("compress-bits");
+            } else if (arg == "--price-index" && has_value) {
+                price_index_path = argv[++i];
+            } else if (arg == "--query-index" && has_value) {
+                query_index_path = argv[++i];
+            } else if (arg == "--cdf" && has_value) {
+                cdf_prices.push_back(std::stod(argv[++i]));
+            } else if (arg == "--quantile" && has_value) {
+                double p = std::stod(argv[++i]);
+                if (!(p >= 0.0 && p <= 1.0)) throw std::invalid_argument("quantile");
+                quantile_levels.push_back(p);
+            } else if (arg == "--sort-samples" && has_value) {
+                sort_samples_path = argv[++i];
+            } else if (arg == "--sort-memory" && has_value) {
+                sort_memory_mb = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--lazy") {
+                lazy = true;
+            } else if (arg == "--cache") {
+                use_cache = true;
+            } else if (arg == "--cache-dir" && has_value) {
+                cache_dir = argv[++i];
+            } else if (arg == "--cache-paths") {
+                cache_paths = true;
+            } else if (arg == "--approx-percentiles") {
+                approx_percentiles = true;
+            } else {
+                std::cerr << "Unknown or incomplete option: " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid option value\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!sort_samples_path.empty()) {
+        return runExternalQuantiles(sort_samples_path, sort_memory_mb, config.num_threads, quantile_levels);
+    }
+    if (!query_index_path.empty()) {
+        try {
+            auto load_start = std::chrono::steady_clock::now();
+            TerminalPriceIndex index = TerminalPriceIndex::load(query_index_path);
+            std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+            std::cout << "Loaded " << query_index_path << " in " << std::fixed << std::setprecision(1)
+                      << load_time.count() << " ms" << std::defaultfloat << std::endl;
+            if (index.empty()) throw std::runtime_error(query_index_path + " holds no prices");
+            printPriceQueries(index, cdf_prices, quantile_levels);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (rng_benchmark || exp_benchmark) {
+        if (rng_benchmark) benchmarkRngEngines(config.seed);
+        if (exp_benchmark) benchmarkExpTiers();
+        return 0;
+    }
+    
+    // Only GBM has an exact transition; other models default to Euler
+    if (model.model != SdeModel::Gbm && model.scheme == SdeScheme::Exact) model.scheme = SdeScheme::Euler;
+    if (model.scheme != SdeScheme::Exact) {
+        if (compress_bits > 0) {
+            std::cerr << "Error: --compress-bits needs the exact GBM scheme (prices must stay positive)\n";
+            return 1;
+        }
+        if (!stream_options.tick_source.empty()) {
+            std::cerr << "Error: streaming mode supports the exact GBM scheme only\n";
+            return 1;
+        }
+        if (!mu_curve_path.empty() || !sigma_curve_path.empty()) {
+            std::cerr << "Error: term structures need the exact GBM scheme\n";
+            return 1;
+        }
+        if (exposure) {
+            std::cerr << "Error: the nested exposure simulation needs the exact GBM scheme\n";
+            return 1;
+        }
+        if (price_barrier) {
+            std::cerr << "Error: the Brownian-bridge barrier correction needs the exact GBM scheme\n";
+            return 1;
+        }
+        if (approx_percentiles) {
+            std::cerr << "Error: --approx-percentiles needs the exact GBM scheme (log-spaced bins)\n";
+            return 1;
+        }
+    }
+
+    if (!stream_options.tick_source.empty() && (!mu_curve_path.empty() || !sigma_curve_path.empty())) {
+        // The forecast is refreshed from the scalar expected return and volatility
+        std::cerr << "Error: streaming mode does not support term structures\n";
+        return 1;
+    }
+
+    if (!shm_name.empty() && !kSharedResultsSupported) {
+        std::cerr << "Error: --shm is unsupported on this platform (needs POSIX shared memory)\n";
+        return 1;
+    }
+    if (lazy && (compress_bits > 0 || price_american || price_barrier || exposure || !shm_name.empty() ||
+                 cache_paths)) {
+        std::cerr << "Error: --lazy keeps no paths; it cannot be combined with --compress-bits, option pricing, "
+                     "--shm or --cache-paths\n";
+        return 1;
+    }
+
     // Default simulation parameters
     SimulationParams params;
+    try {
+        if (!mu_curve_path.empty()) params.mu_curve = loadTermStructure(mu_curve_path, curve_interpolation);
+        if (!sigma_curve_path.empty()) params.sigma_curve = loadTermStructure(sigma_curve_path, curve_interpolation);
+        BusinessCalendar calendar;
+        if (!holidays_path.empty()) calendar = loadHolidays(holidays_path);
+        if (!calendar_start.empty()) {
+            long start, end;
+            if (!parseDate(calendar_start, start) || !parseDate(calendar_end, end)) {
+                throw std::runtime_error("invalid --calendar dates");
+            }
+            params.time_grid = businessDayGrid(start, end, calendar);
+        } else if (!time_grid_path.empty()) {
+            bool business_time = business_days || !holidays_path.empty();
+            params.time_grid = loadTimeGrid(time_grid_path, business_time ? &calendar : nullptr);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
     
     // Get user input for simulation parameters
     std::cout << "Monte Carlo Stock Price Simulation\n";
@@ -318,34 +2500,303 @@ int main() {
     std::cout << "Enter annual volatility (as decimal, e.g., 0.20 for 20%): ";
     std::cin >> params.sigma;
     
-    std::cout << "Enter time period (in years): ";
-    std::cin >> params.T;
-    
-    std::cout << "Enter number of time steps: ";
-    std::cin >> params.steps;
+    if (params.time_grid.empty()) {
+        std::cout << "Enter time period (in years): ";
+        std::cin >> params.T;
+        
+        std::cout << "Enter number of time steps: ";
+        std::cin >> params.steps;
+    } else {
+        // The time grid fixes the horizon and the steps
+        params.T = params.time_grid.back();
+        params.steps = params.time_grid.size() - 1;
+        std::cout << "Time grid: " << params.steps << " steps over " << params.T << " years\n";
+    }
     
     std::cout << "Enter number of simulation paths: ";
     std::cin >> params.num_paths;
     
+    params.model = model;
+    if (!theta_given) params.model.theta = params.S0;
+    // Options share the strike and the discount rate
+    american.strike = barrier.strike = strike_given ? strike : params.S0;
+    american.rate = barrier.rate = exposure_option.rate = rate_given ? rate : params.mu;
+    exposure_option.strike = american.strike;
+    if (price_american && params.model.scheme != SdeScheme::Exact && american.rate != params.mu) {
+        // Discretized paths cannot be moved to another drift after the fact
+        std::cerr << "Error: with --model/--scheme the American option is priced on the simulated paths; "
+                     "--rate must equal the expected return\n";
+        return 1;
+    }
+    if (price_barrier && !barrier_type_given) {
+        barrier.type = barrier.level > params.S0 ? BarrierOption::Type::UpOut : BarrierOption::Type::DownOut;
+    }
+    
+    if (!stream_options.tick_source.empty()) {
+        return runStreamingSimulation(params, stream_options, config);
+    }
+    
+    // Engine settings: tune now, or reuse a saved profile unless set explicitly
+    if (autotune) {
+        double best_rate;
+        config = autotuneEngine(params, config, best_rate);
+        saveTunedConfig(profile_path, params, config, best_rate);
+        std::cout << "Best settings saved to " << profile_path << ".\n";
+    } else if (!engine_overridden) {
+        // A fixed seed keeps its results: only the thread count is tuned unless opted in
+        bool threads_only = seed_given && !use_full_profile;
+        if (loadTunedConfig(profile_path, params, config, threads_only)) {
+            std::cout << "\nUsing autotuned settings from " << profile_path << ": " << config.num_threads
+                      << " threads";
+            if (threads_only) {
+                std::cout << " (layout and block size kept for the fixed seed; --use-profile applies them)";
+            } else {
+                std::cout << ", " << layoutName(config.layout) << "-major";
+                if (config.layout == PathLayout::StepMajor) std::cout << ", block " << config.block_size;
+            }
+            std::cout << ".\n";
+        }
+    }
+    // Discretized SDEs are always stepped in lockstep
+    if (params.model.scheme != SdeScheme::Exact) config.layout = PathLayout::StepMajor;
+    
+    // Identical runs (same parameters, seed, engine and outputs) are served from the cache
+    ResultCache cache(cache_dir);
+    std::string cache_key;
+    if (use_cache && !seed_given) {
+        std::cout << "\nNote: --cache needs a fixed --seed; caching disabled for this run.\n";
+        use_cache = false;
+    }
+    if (use_cache && (price_american || price_barrier || path_metrics || exposure || !price_index_path.empty() ||
+                      !cdf_prices.empty() || !quantile_levels.empty())) {
+        std::cout << "\nNote: option prices, path statistics and price queries are not cached; caching disabled for "
+                     "this run.\n";
+        use_cache = false;
+    }
+    if (use_cache && !shm_name.empty()) {
+        // A cache hit would return before the segment is created and filled
+        std::cout << "\nNote: --shm publishes a live run; caching disabled for this run.\n";
+        use_cache = false;
+    }
+    if (use_cache) {
+        auto lookup_start = std::chrono::steady_clock::now();
+        cache_key = resultCacheKey(params, config, compress_bits, confidence, approx_percentiles);
+        std::string cached;
+        FinalPriceStatistics cached_stats;
+        if (cache.lookup(cache_key, cached) && parseStatistics(cached, cached_stats)) {
+            std::chrono::duration<double, std::micro> lookup_time = std::chrono::steady_clock::now() - lookup_start;
+            std::cout << "\nLoaded cached results from " << cache.entryPath(cache_key, "stats") << " in "
+                      << std::fixed << std::setprecision(0) << lookup_time.count() << " microseconds.\n";
+            printStatistics(cached_stats, target_half_width);
+            if (std::filesystem::exists(cache.entryPath(cache_key, "paths"))) {
+                std::cout << "Cached paths: " << cache.entryPath(cache_key, "paths") << std::endl;
+            }
+            std::cout << "\nNote: only the statistics are cached; the CSV files (paths, time points, display paths, "
+                         "histogram, density, step statistics) and stock_price_plot.html were not regenerated and "
+                         "may be missing or from an earlier run. Run without --cache to write them.\n";
+            return 0;
+        }
+    }
+    
     std::cout << "\nRunning Monte Carlo simulation...\n";
     
     // Run the simulation
     auto start_time = std::chrono::high_resolution_clock::now();
-    std::vector<std::vector<double>> paths = runMonteCarloSimulation(params);
+    LogHistogram histogram;
+    StepStatistics step_stats;
+    std::unique_ptr<CompressedPathStore> store;
+    if (compress_bits > 0) {
+        store = std::make_unique<CompressedPathStore>(params.num_paths, params.steps, params.S0, compress_bits);
+    }
+    std::unique_ptr<PathMetrics> metrics;
+    if (path_metrics) {
+        metrics = std::make_unique<PathMetrics>(params.num_paths, passage_level, passage_level >= params.S0);
+    }
+    std::unique_ptr<SharedResultsPublisher> publisher;
+    if (!shm_name.empty()) {
+        try {
+            publisher = std::make_unique<SharedResultsPublisher>(shm_name, params.num_paths, params.steps,
+                                                                 kPathsPerBlock, shm_paths);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        std::cout << "Publishing results in shared memory " << shm_name << " (" << std::fixed
+                  << std::setprecision(1) << publisher->bytes() / 1048576.0 << " MB)" << std::defaultfloat
+                  << "\n";
+    }
+    const std::string engine_description = describeEngine(params, config);
+    std::vector<std::vector<double>> paths;
+    std::vector<double> lazy_final_prices;
+    std::vector<std::vector<double>> lazy_display_paths;
+    if (lazy) {
+        // Pull the paths block by block: each block is written out as soon as
+        // it is generated and only the final prices and plotted paths are kept
+        lazy_final_prices.resize(params.num_paths);
+        PathsCsvWriter writer(params, engine_description);
+        // The consumer is the only thread that sees finished blocks, so it
+        // ticks a single counter
+        std::unique_ptr<ProgressReporter> progress;
+        if (config.show_progress) progress = std::make_unique<ProgressReporter>(params.num_paths, 1);
+        for (PathBlock& block : simulatePathBlocks(params, config, &histogram, &step_stats, metrics.get())) {
+            writer.write(block.first, block.paths);
+            if (progress) progress->add(0, block.paths.size());
+            for (std::size_t k = 0; k < block.paths.size(); ++k) {
+                lazy_final_prices[block.first + k] = block.paths[k][params.steps];
+                if (block.first + k < static_cast<std::size_t>(display_paths)) {
+                    lazy_display_paths.push_back(std::move(block.paths[k]));
+                }
+            }
+        }
+        if (progress) progress->finish();
+        writer.finish();
+    } else {
+        paths = runMonteCarloSimulation(params, config, &histogram, &step_stats, store.get(), metrics.get(),
+                                        publisher.get());
+    }
     auto end_time = std::chrono::high_resolution_clock::now();
     
     // Calculate execution time
     std::chrono::duration<double> elapsed = end_time - start_time;
-    std::cout << "Simulation completed in " << elapsed.count() << " seconds.\n";
+    std::cout << "Simulation completed in " << elapsed.count() << " seconds (" << config.num_threads
+              << " threads, " << layoutName(config.layout) << "-major";
+    if (config.layout == PathLayout::StepMajor) {
+        std::cout << ", block " << config.block_size;
+    }
+    std::cout << ", seed " << config.seed << (lazy ? ", lazy, including writing the paths" : "") << ").\n";
+    if (params.model.scheme != SdeScheme::Exact) {
+        std::cout << "Model: " << modelName(params.model.model) << ", " << schemeName(params.model.scheme)
+                  << " scheme\n";
+    } else if (config.layout == PathLayout::StepMajor) {
+        StepKernel kernel = selectStepKernel(config.isa, config.exp_tier);
+        std::cout << "Step kernel: " << kernel.name;
+        if (config.isa == KernelIsa::Auto) {
+            std::cout << " (auto-detected)";
+        } else if (kernel.isa != config.isa) {
+            std::cout << " (requested variant not supported by this CPU)";
+        }
+        std::cout << ", exp tier " << expTierName(kernel.tier) << "\n";
+    } else {
+        std::cout << "Exp tier: " << expTierName(config.exp_tier) << "\n";
+    }
+    if (store) {
+        double full_bytes = static_cast<double>(params.num_paths) * (params.steps + 1) * sizeof(double);
+        std::cout << "Compressed paths (" << store->bits() << "-bit log-returns): " << std::fixed
+                  << std::setprecision(1) << store->bytes() / 1048576.0 << " MB instead of "
+                  << full_bytes / 1048576.0 << " MB, max relative price error " << std::scientific
+                  << std::setprecision(2) << store->maxRelativeError() << std::defaultfloat << "\n";
+    }
     
     // Calculate and display statistics
-    calculateStatistics(paths, params);
+    std::vector<double> final_prices = lazy  ? std::move(lazy_final_prices)
+                                     : store ? extractFinalPrices(*store, config.num_threads)
+                                             : extractFinalPrices(paths, params);
+    FinalPriceStatistics stats = calculateStatistics(final_prices, config.num_threads, confidence,
+                                                     approx_percentiles ? &histogram : nullptr);
+    printStatistics(stats, target_half_width);
+    if (publisher) {
+        double shared[kSharedStatisticCount];
+        shared[kSharedPaths] = stats.num_paths;
+        shared[kSharedMean] = stats.mean.value;
+        shared[kSharedMeanStdError] = stats.mean.std_error;
+        shared[kSharedStdDev] = stats.std_dev.value;
+        shared[kSharedMin] = stats.min_price;
+        shared[kSharedMax] = stats.max_price;
+        shared[kSharedPercentile5] = stats.percentile_5.value;
+        shared[kSharedPercentile95] = stats.percentile_95.value;
+        publisher->publishStatistics(shared, true);
+    }
+    if (!price_index_path.empty() || !cdf_prices.empty() || !quantile_levels.empty()) {
+        TerminalPriceIndex index(final_prices, config.num_threads);
+        if (!cdf_prices.empty() || !quantile_levels.empty()) printPriceQueries(index, cdf_prices, quantile_levels);
+        if (!price_index_path.empty()) {
+            try {
+                index.save(price_index_path);
+                std::cout << "Terminal price index (" << index.size() << " sorted floats) saved to "
+                          << price_index_path << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+            }
+        }
+    }
+    PathMetricsSummary metrics_summary;
+    if (metrics) {
+        metrics_summary = summarizePathMetrics(*metrics, params, config.num_threads, confidence);
+        printPathMetrics(metrics_summary, *metrics, confidence);
+    }
+    if (price_american) {
+        auto lsm_start = std::chrono::steady_clock::now();
+        LsmResult american_price = store ? priceAmericanOption(*store, params, american, exercise_dates,
+                                                               config.num_threads)
+                                         : priceAmericanOption(paths, params, american, exercise_dates,
+                                                               config.num_threads);
+        std::chrono::duration<double> lsm_time = std::chrono::steady_clock::now() - lsm_start;
+        printAmericanOption(american_price, american, std::min(exercise_dates, params.steps), confidence);
+        std::cout << "(priced in " << std::setprecision(3) << lsm_time.count() << " seconds)" << std::endl;
+    }
+    ExposureProfile exposure_profile;
+    if (exposure) {
+        auto nested_start = std::chrono::steady_clock::now();
+        exposure_profile = store ? computeExposureProfile(*store, params, config, exposure_option, exposure_dates,
+                                                          inner_paths)
+                                 : computeExposureProfile(paths, params, config, exposure_option, exposure_dates,
+                                                          inner_paths);
+        std::chrono::duration<double> nested_time = std::chrono::steady_clock::now() - nested_start;
+        printExposureProfile(exposure_profile, exposure_option, inner_paths, nested_time.count());
+    }
+    if (price_barrier) {
+        BarrierResult barrier_price = store ? priceBarrierOption(*store, params, barrier, confidence,
+                                                                 config.num_threads)
+                                            : priceBarrierOption(paths, params, barrier, confidence,
+                                                                 config.num_threads);
+        printBarrierOption(barrier_price, barrier, params.steps, confidence);
+    }
+    if (use_cache) {
+        cache.store(cache_key, serializeStatistics(stats));
+        if (cache_paths) {
+            // Raw native-endian doubles, num_paths rows of steps + 1 prices
+            auto writePaths = [&](std::ostream& out) {
+                auto writeBlock = [&](int, const std::vector<std::vector<double>>& block) {
+                    for (const auto& path : block) {
+                        out.write(reinterpret_cast<const char*>(path.data()), path.size() * sizeof(double));
+                    }
+                };
+                if (store) {
+                    forEachPathBlock(*store, writeBlock);
+                } else {
+                    forEachPathBlock(paths, writeBlock);
+                }
+            };
+            cache.storeData(cache_key, "paths", writePaths);
+        }
+    }
+    DensityEstimate density = estimateFinalPriceDensity(final_prices, stats, kde_points, config.num_threads);
     
     // Save results to CSV files
-    saveResultsToCSV(paths, params);
+    if (lazy) {
+        saveDisplayPathsToCSV(lazy_display_paths, params, display_paths, plot_points, config.num_threads);
+    } else if (store) {
+        saveResultsToCSV(*store, params, engine_description);
+        saveDisplayPathsToCSV(store->decodeBlock(0, display_paths), params, display_paths, plot_points,
+                              config.num_threads);
+    } else {
+        saveResultsToCSV(paths, params, engine_description);
+        saveDisplayPathsToCSV(paths, params, display_paths, plot_points, config.num_threads);
+    }
+    saveHistogramToCSV(histogram);
+    saveDensityToCSV(density);
+    if (step_stats.count > 0) {
+        saveStepStatisticsToCSV(step_stats, params, engine_description);
+    }
+    if (exposure) {
+        saveExposureProfileToCSV(exposure_profile);
+    }
+    if (metrics) {
+        savePathMetricsToCSV(metrics_summary, params, params.num_paths);
+    }
     
     // Generate HTML plot
-    generatePlotHTML(params);
+    generatePlotHTML(params, engine_description);
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef NESTED_H
+#define NESTED_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "parallel.h"
+
+// European call or put, valued by inner simulations in the nested driver
+struct VanillaOption {
+    bool is_call = true;
+    double strike = 100.0;
+    double rate = 0.0;  // Continuously compounded risk-free rate of the inner simulations
+
+    double payoff(double price) const {
+        return std::max(is_call ? price - strike : strike - price, 0.0);
+    }
+};
+
+// Value every outer scenario by an inner Monte Carlo simulation:
+//     values[o] = discount * mean_k payoff(outer[o] * growth[k])
+// where growth[k] = S_T / S_t of inner scenario k. The growth factors come
+// from one set of normalized inner shocks shared by all outer scenarios, so
+// they are computed once per date and every inner simulation reduces to a
+// multiply and a payoff. The work is split into (outer chunk, inner chunk)
+// tasks for a single level of parallelFor, which keeps all threads busy
+// whether there are few outer scenarios or few inner ones without nesting
+// thread pools. Within a task the inner loop is outermost, so the update of
+// a batch of outer scenarios vectorizes. Partial sums per inner chunk are
+// combined in a fixed order, so values do not depend on the thread count.
+// inner_std_error[o], if given, receives the standard error of values[o].
+template <typename Payoff>
+void valueWithInnerSimulation(const double* outer, std::size_t num_outer, const std::vector<double>& growth,
+                              double discount, Payoff payoff, int num_threads, double* values,
+                              double* inner_std_error = nullptr) {
+    const std::size_t kOuterChunk = 256;
+    const std::size_t kInnerChunk = 4096;
+    const std::size_t num_inner = growth.size();
+    const std::size_t outer_chunks = (num_outer + kOuterChunk - 1) / kOuterChunk;
+    const std::size_t inner_chunks = (num_inner + kInnerChunk - 1) / kInnerChunk;
+    std::vector<double> partial_sums(inner_chunks * num_outer);
+    std::vector<double> partial_squares(inner_std_error ? inner_chunks * num_outer : 0);
+
+    parallelFor(static_cast<int>(outer_chunks * inner_chunks), num_threads, [&](int task, int) {
+        std::size_t outer_begin = task / inner_chunks * kOuterChunk;
+        std::size_t inner_chunk = task % inner_chunks;
+        std::size_t count = std::min(kOuterChunk, num_outer - outer_begin);
+        std::size_t inner_begin = inner_chunk * kInnerChunk;
+        std::size_t inner_end = std::min(inner_begin + kInnerChunk, num_inner);
+        const double* s = outer + outer_begin;
+        double sums[kOuterChunk] = {};
+        double squares[kOuterChunk] = {};
+
+        for (std::size_t k = inner_begin; k < inner_end; ++k) {
+            const double g = growth[k];
+            if (inner_std_error) {
+                for (std::size_t o = 0; o < count; ++o) {
+                    double v = payoff(s[o] * g);
+                    sums[o] += v;
+                    squares[o] += v * v;
+                }
+            } else {
+                for (std::size_t o = 0; o < count; ++o) sums[o] += payoff(s[o] * g);
+            }
+        }
+        std::copy(sums, sums + count, &partial_sums[inner_chunk * num_outer + outer_begin]);
+        if (inner_std_error) {
+            std::copy(squares, squares + count, &partial_squares[inner_chunk * num_outer + outer_begin]);
+        }
+    });
+
+    for (std::size_t o = 0; o < num_outer; ++o) {
+        double sum = 0.0, sum_squares = 0.0;
+        for (std::size_t c = 0; c < inner_chunks; ++c) {
+            sum += partial_sums[c * num_outer + o];
+            if (inner_std_error) sum_squares += partial_squares[c * num_outer + o];
+        }
+        double mean = sum / num_inner;
+        values[o] = discount * mean;
+        if (inner_std_error) {
+            double variance = num_inner > 1 ? std::max(sum_squares - num_inner * mean * mean, 0.0) / (num_inner - 1)
+                                            : 0.0;
+            inner_std_error[o] = discount * std::sqrt(variance / num_inner);
+        }
+    }
+}
+
+#endif // NESTED_H
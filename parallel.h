@@ -0,0 +1,125 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Run task(index, thread_id) for every index in [0, num_tasks) on up to
+// num_threads threads. Tasks are handed out dynamically, so callers must not
+// rely on which thread runs which task; thread_id is only meant for indexing
+// per-thread scratch data. The calling thread participates as thread 0.
+template <typename Task>
+void parallelFor(int num_tasks, int num_threads, Task task) {
+    num_threads = std::max(1, std::min(num_threads, num_tasks));
+    std::atomic<int> next_task{0};
+
+    auto worker = [&](int thread_id) {
+        for (int index = next_task++; index < num_tasks; index = next_task++) {
+            task(index, thread_id);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Combines the partial results of the tasks of a parallelFor in task order,
+// although the tasks finish in any order: a submitted partial waits until
+// every earlier one has been merged. merge(total, partial) therefore always
+// sees the same sequence and the result is the same for any thread count.
+// Only the partials of tasks that finished ahead of an earlier one are held.
+template <typename T, typename Merge>
+class OrderedReduction {
+public:
+    OrderedReduction(int num_tasks, T initial, Merge merge)
+        : total_(std::move(initial)), merge_(std::move(merge)), pending_(num_tasks) {}
+
+    void submit(int task, T partial) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_[task] = std::move(partial);
+        while (next_ < pending_.size() && pending_[next_]) {
+            merge_(total_, *pending_[next_]);
+            pending_[next_++].reset();
+        }
+    }
+
+    // Valid once every task has been submitted
+    T& result() { return total_; }
+
+private:
+    T total_;
+    Merge merge_;
+    std::vector<std::optional<T>> pending_;
+    std::size_t next_ = 0;
+    std::mutex mutex_;
+};
+
+// Compensated (Kahan-Babuska-Neumaier) running sum
+struct CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    void add(double x) {
+        double t = sum + x;
+        if (std::fabs(sum) >= std::fabs(x)) {
+            compensation += (sum - t) + x;
+        } else {
+            compensation += (x - t) + sum;
+        }
+        sum = t;
+    }
+
+    double value() const { return sum + compensation; }
+};
+
+// Elements per reduction block. The block partition depends only on n, never
+// on the thread count, which is what makes the reductions reproducible.
+const std::size_t kReductionBlock = 4096;
+
+// Sum partials[first, last) by recursive halving (a fixed binary tree)
+inline double pairwiseSum(const std::vector<double>& partials, std::size_t first, std::size_t last) {
+    if (last - first == 1) return partials[first];
+    std::size_t middle = first + (last - first) / 2;
+    return pairwiseSum(partials, first, middle) + pairwiseSum(partials, middle, last);
+}
+
+// Sum of f(data[i]) for i in [0, n) that is bit-identical for any num_threads.
+// Each fixed block of kReductionBlock elements is summed with compensation and
+// the block partials are combined in a fixed pairwise tree.
+template <typename Transform>
+double deterministicSum(const double* data, std::size_t n, int num_threads, Transform f) {
+    if (n == 0) return 0.0;
+    std::size_t num_blocks = (n + kReductionBlock - 1) / kReductionBlock;
+    std::vector<double> partials(num_blocks);
+
+    parallelFor(static_cast<int>(num_blocks), num_threads, [&](int block, int) {
+        std::size_t begin = block * kReductionBlock;
+        std::size_t end = std::min(begin + kReductionBlock, n);
+        CompensatedSum sum;
+        for (std::size_t i = begin; i < end; ++i) {
+            sum.add(f(data[i]));
+        }
+        partials[block] = sum.value();
+    });
+
+    return pairwiseSum(partials, 0, num_blocks);
+}
+
+inline double deterministicSum(const double* data, std::size_t n, int num_threads) {
+    return deterministicSum(data, n, num_threads, [](double x) { return x; });
+}
+
+#endif // PARALLEL_H
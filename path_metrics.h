@@ -0,0 +1,65 @@
+#ifndef PATH_METRICS_H
+#define PATH_METRICS_H
+
+#include <algorithm>
+#include <vector>
+
+// Per-path first-passage and drawdown results, filled by the path kernels
+struct PathMetrics {
+    double passage_level = 0.0;     // Level whose first passage is tracked; 0 disables it
+    bool passage_up = true;         // Passage when the price rises to the level (else falls to it)
+    std::vector<double> max_drawdown;  // Largest fall from a running peak, as a fraction of the peak
+    std::vector<int> passage_step;     // First step at or beyond the level; -1 if never reached
+
+    PathMetrics() = default;
+    PathMetrics(int num_paths, double level, bool up)
+        : passage_level(level), passage_up(up), max_drawdown(num_paths, 0.0), passage_step(num_paths, -1) {}
+
+    bool tracksPassage() const { return passage_level > 0.0; }
+};
+
+// Running state of a block of paths advanced in lockstep: the running peak,
+// the deepest drawdown so far and the first passage step of every lane. The
+// kernels call update() with the current prices after each step, so the
+// metrics come out of the same pass that generates the paths. Blocks cover
+// disjoint paths, so trackers on different threads write to disjoint parts
+// of the PathMetrics.
+class PathMetricsTracker {
+public:
+    PathMetricsTracker(PathMetrics& metrics, int first_path, int n, double S0)
+        : metrics_(metrics), first_path_(first_path), running_max_(n, S0), max_drawdown_(n, 0.0),
+          passage_step_(n, -1) {
+        if (metrics_.tracksPassage()) update(0, running_max_.data());
+    }
+
+    void update(int step, const double* prices) {
+        const int n = static_cast<int>(running_max_.size());
+        double* peak = running_max_.data();
+        double* drawdown = max_drawdown_.data();
+        for (int j = 0; j < n; ++j) {
+            peak[j] = std::max(peak[j], prices[j]);
+            drawdown[j] = std::max(drawdown[j], 1.0 - prices[j] / peak[j]);
+        }
+        if (!metrics_.tracksPassage()) return;
+        const double level = metrics_.passage_level;
+        for (int j = 0; j < n; ++j) {
+            bool reached = metrics_.passage_up ? prices[j] >= level : prices[j] <= level;
+            if (reached && passage_step_[j] < 0) passage_step_[j] = step;
+        }
+    }
+
+    // Write the lanes' results to paths [first_path, first_path + n)
+    void finish() const {
+        std::copy(max_drawdown_.begin(), max_drawdown_.end(), metrics_.max_drawdown.begin() + first_path_);
+        std::copy(passage_step_.begin(), passage_step_.end(), metrics_.passage_step.begin() + first_path_);
+    }
+
+private:
+    PathMetrics& metrics_;
+    int first_path_;
+    std::vector<double> running_max_;
+    std::vector<double> max_drawdown_;
+    std::vector<int> passage_step_;
+};
+
+#endif // PATH_METRICS_H
@@ -0,0 +1,136 @@
+#ifndef PATH_STORE_H
+#define PATH_STORE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compressed in-memory storage for simulated price paths.
+//
+// Each path is stored as its per-step log-returns, quantized to `bits`-bit
+// signed integers with a per-path scale and bit-packed into 64-bit words.
+// Quantization uses error feedback: every step quantizes the difference
+// between the true log-price and the already reconstructed one, so rounding
+// errors do not accumulate along the path. With
+//     scale = max|log-return| / (2^(bits-1) - 1)
+// the reconstructed log-price at every step is within scale/2 of the true one,
+// i.e. every decoded price has a relative error of at most exp(scale/2) - 1.
+// For 20% volatility and daily steps that is about 1e-6 at 16 bits and 2e-4
+// at 8 bits, for 4x and 8x less memory than doubles.
+//
+// Paths occupy disjoint words, so different threads may store different
+// paths concurrently.
+class CompressedPathStore {
+public:
+    CompressedPathStore(int num_paths, int steps, double S0, int bits)
+        : num_paths_(num_paths), steps_(steps), bits_(std::min(std::max(bits, 2), 32)), log_S0_(std::log(S0)),
+          words_per_path_((static_cast<std::size_t>(steps) * bits_ + 63) / 64),
+          words_(words_per_path_ * num_paths, 0), scales_(num_paths, 0.0) {}
+
+    // Compress prices[0..steps] of one path (prices[0] must be S0)
+    void storePath(int path, const double* prices) {
+        const std::int64_t max_code = (std::int64_t(1) << (bits_ - 1)) - 1;
+        double max_return = 0.0;
+        for (int i = 1; i <= steps_; ++i) {
+            max_return = std::max(max_return, std::fabs(std::log(prices[i] / prices[i - 1])));
+        }
+        double scale = max_return > 0.0 ? max_return / max_code : 1.0;
+        scales_[path] = scale;
+
+        std::uint64_t* words = &words_[path * words_per_path_];
+        std::fill(words, words + words_per_path_, 0);
+        double reconstructed = 0.0;  // Quantized log(price / S0)
+        for (int i = 1; i <= steps_; ++i) {
+            double target = std::log(prices[i]) - log_S0_;
+            std::int64_t code = std::llround((target - reconstructed) / scale);
+            code = std::min(std::max(code, -max_code), max_code);
+            reconstructed += code * scale;
+            writeBits(words, static_cast<std::size_t>(i - 1) * bits_, static_cast<std::uint64_t>(code));
+        }
+    }
+
+    // Decode one path into prices[0..steps]
+    void decodePath(int path, double* prices) const {
+        const std::uint64_t* words = &words_[path * words_per_path_];
+        double scale = scales_[path];
+        double log_price = 0.0;
+        prices[0] = std::exp(log_S0_);
+        for (int i = 1; i <= steps_; ++i) {
+            log_price += readCode(words, static_cast<std::size_t>(i - 1) * bits_) * scale;
+            prices[i] = std::exp(log_S0_ + log_price);
+        }
+    }
+
+    // Decode paths [first, first + count) as full price vectors
+    std::vector<std::vector<double>> decodeBlock(int first, int count) const {
+        count = std::max(0, std::min(count, num_paths_ - first));
+        std::vector<std::vector<double>> block(count, std::vector<double>(steps_ + 1));
+        for (int p = 0; p < count; ++p) {
+            decodePath(first + p, block[p].data());
+        }
+        return block;
+    }
+
+    // Final price of one path, summing the codes without materializing the path
+    double finalPrice(int path) const {
+        const std::uint64_t* words = &words_[path * words_per_path_];
+        std::int64_t code_sum = 0;
+        for (int i = 0; i < steps_; ++i) {
+            code_sum += readCode(words, static_cast<std::size_t>(i) * bits_);
+        }
+        return std::exp(log_S0_ + code_sum * scales_[path]);
+    }
+
+    // Largest relative price error of any stored value: exp(max scale / 2) - 1
+    double maxRelativeError() const {
+        double max_scale = 0.0;
+        for (double scale : scales_) max_scale = std::max(max_scale, scale);
+        return std::expm1(0.5 * max_scale);
+    }
+
+    std::size_t bytes() const {
+        return words_.size() * sizeof(std::uint64_t) + scales_.size() * sizeof(double);
+    }
+
+    int numPaths() const { return num_paths_; }
+    int steps() const { return steps_; }
+    int bits() const { return bits_; }
+
+private:
+    void writeBits(std::uint64_t* words, std::size_t bit_offset, std::uint64_t value) const {
+        value &= mask();
+        std::size_t word = bit_offset / 64;
+        unsigned shift = bit_offset % 64;
+        words[word] |= value << shift;
+        if (shift + bits_ > 64) {
+            words[word + 1] |= value >> (64 - shift);
+        }
+    }
+
+    std::int64_t readCode(const std::uint64_t* words, std::size_t bit_offset) const {
+        std::size_t word = bit_offset / 64;
+        unsigned shift = bit_offset % 64;
+        std::uint64_t value = words[word] >> shift;
+        if (shift + bits_ > 64) {
+            value |= words[word + 1] << (64 - shift);
+        }
+        value &= mask();
+        // Sign-extend the bits-wide two's complement code
+        std::uint64_t sign = std::uint64_t(1) << (bits_ - 1);
+        return static_cast<std::int64_t>(value ^ sign) - static_cast<std::int64_t>(sign);
+    }
+
+    std::uint64_t mask() const { return (std::uint64_t(1) << bits_) - 1; }
+
+    int num_paths_;
+    int steps_;
+    int bits_;
+    double log_S0_;
+    std::size_t words_per_path_;
+    std::vector<std::uint64_t> words_;
+    std::vector<double> scales_;
+};
+
+#endif // PATH_STORE_H
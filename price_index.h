@@ -0,0 +1,97 @@
+#ifndef PRICE_INDEX_H
+#define PRICE_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "radix_sort.h"
+
+// Sorted final prices of a run, kept as floats (4 bytes per path), answering
+// distribution queries by binary search in O(log n):
+//   probabilityBelow(K)  - P(S_T < K), the fraction of paths ending below K
+//   quantile(p)          - the price at rank floor(p * n), as in the statistics
+// Floats keep 24 significant bits, so prices are rounded by at most 6e-8 of
+// their value; a K closer than that to a simulated price may count it on
+// either side.
+//
+// File layout (native endianness): the 8-byte magic "MCPRIDX1", a uint32
+// format version, a uint32 value size (4), a uint64 path count, then the
+// sorted prices.
+class TerminalPriceIndex {
+public:
+    TerminalPriceIndex() = default;
+
+    explicit TerminalPriceIndex(const std::vector<double>& final_prices, int num_threads = 1)
+        : sorted_(final_prices.begin(), final_prices.end()) {
+        // Rounding to float is monotone, so sorting the floats sorts the prices
+        radixSort(sorted_, num_threads);
+    }
+
+    std::size_t size() const { return sorted_.size(); }
+    bool empty() const { return sorted_.empty(); }
+    double min() const { return sorted_.front(); }
+    double max() const { return sorted_.back(); }
+
+    double probabilityBelow(double price) const {
+        if (sorted_.empty()) return 0.0;
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), price,
+                                   [](float value, double key) { return value < key; });
+        return static_cast<double>(it - sorted_.begin()) / sorted_.size();
+    }
+
+    // p in [0, 1]; the rank is clamped to the sample
+    double quantile(double p) const {
+        if (sorted_.empty()) return std::nan("");
+        double rank = std::floor(p * sorted_.size());
+        std::size_t index = rank <= 0.0 ? 0 : std::min(static_cast<std::size_t>(rank), sorted_.size() - 1);
+        return sorted_[index];
+    }
+
+    void save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        std::uint32_t version = kVersion;
+        std::uint32_t value_bytes = sizeof(float);
+        std::uint64_t count = sorted_.size();
+        out.write(kMagic, sizeof(kMagic));
+        out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        out.write(reinterpret_cast<const char*>(&value_bytes), sizeof(value_bytes));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(sorted_.data()), sorted_.size() * sizeof(float));
+        if (!out) throw std::runtime_error("cannot write price index " + path);
+    }
+
+    static TerminalPriceIndex load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("cannot open price index " + path);
+        char magic[8];
+        std::uint32_t version = 0, value_bytes = 0;
+        std::uint64_t count = 0;
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char*>(&version), sizeof(version));
+        in.read(reinterpret_cast<char*>(&value_bytes), sizeof(value_bytes));
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion ||
+            value_bytes != sizeof(float)) {
+            throw std::runtime_error(path + " is not a price index of a supported version");
+        }
+        TerminalPriceIndex index;
+        index.sorted_.resize(count);
+        in.read(reinterpret_cast<char*>(index.sorted_.data()), count * sizeof(float));
+        if (!in) throw std::runtime_error("price index " + path + " is truncated");
+        return index;
+    }
+
+private:
+    static constexpr char kMagic[8] = {'M', 'C', 'P', 'R', 'I', 'D', 'X', '1'};
+    static constexpr std::uint32_t kVersion = 1;
+
+    std::vector<float> sorted_;
+};
+
+#endif // PRICE_INDEX_H
@@ -0,0 +1,93 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Progress display for long runs. Each worker thread bumps its own counter
+// (on a separate cache line, so workers never contend) and a reporter thread
+// samples the counters a few times per second to print percent complete,
+// throughput and ETA. Workers never perform I/O.
+class ProgressReporter {
+public:
+    ProgressReporter(long long total, int num_threads, std::ostream& out = std::cerr,
+                     std::chrono::milliseconds interval = std::chrono::milliseconds(250))
+        : total_(total), num_threads_(num_threads), counters_(new PaddedCounter[num_threads]),
+          out_(out), interval_(interval), start_time_(std::chrono::steady_clock::now()),
+          reporter_([this] { run(); }) {}
+
+    ~ProgressReporter() { finish(); }
+
+    // Called by worker thread_id after completing n more units. Only the owning
+    // thread writes its counter, so a relaxed load/store pair is enough.
+    void add(int thread_id, long long n) {
+        std::atomic<long long>& counter = counters_[thread_id].value;
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // Stop the reporter and print the final line
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (done_) return;
+            done_ = true;
+        }
+        wake_.notify_one();
+        reporter_.join();
+        print();
+        out_ << std::endl;
+    }
+
+private:
+    struct alignas(64) PaddedCounter {
+        std::atomic<long long> value{0};
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval_, [this] { return done_; })) {
+            print();
+        }
+    }
+
+    void print() {
+        long long completed = 0;
+        for (int t = 0; t < num_threads_; ++t) {
+            completed += counters_[t].value.load(std::memory_order_relaxed);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time_;
+        double rate = elapsed.count() > 0.0 ? completed / elapsed.count() : 0.0;
+        double percent = total_ > 0 ? 100.0 * completed / total_ : 100.0;
+
+        std::ios_base::fmtflags flags = out_.flags();
+        out_ << "\r[" << std::fixed << std::setprecision(1) << std::setw(5) << percent << "%] "
+             << completed << "/" << total_ << " paths, " << std::setprecision(0) << rate << " paths/sec";
+        if (rate > 0.0 && completed < total_) {
+            out_ << ", ETA " << std::setprecision(1) << (total_ - completed) / rate << " s   ";
+        } else {
+            out_ << ", " << std::setprecision(2) << elapsed.count() << " s elapsed   ";
+        }
+        out_.flush();
+        out_.flags(flags);
+    }
+
+    long long total_;
+    int num_threads_;
+    std::unique_ptr<PaddedCounter[]> counters_;
+    std::ostream& out_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool done_ = false;
+    std::thread reporter_;  // Declared last so it starts after the other members
+};
+
+#endif // PROGRESS_H
@@ -0,0 +1,272 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "parallel.h"
+
+// Sorting of floating-point samples by the bit patterns of their values.
+// Flipping the sign bit of non-negative values and every bit of negative
+// ones turns IEEE 754 order into unsigned integer order, so the keys can be
+// sorted digit by digit without comparisons. -0.0 sorts before 0.0; NaNs
+// must not occur.
+
+template <typename T>
+using RadixKey = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+
+template <typename T>
+inline RadixKey<T> radixKey(T value) {
+    static_assert(std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "float or double only");
+    using Key = RadixKey<T>;
+    Key bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const Key sign = Key(1) << (8 * sizeof(Key) - 1);
+    return (bits & sign) ? ~bits : bits | sign;
+}
+
+const int kRadixDigitBits = 11;  // 2048 buckets: 6 passes for doubles, 3 for floats
+const std::size_t kRadixMinSize = 1 << 16;  // Below this std::sort is faster
+
+// Parallel LSD radix sort of data[0, n). Each pass splits the array into one
+// contiguous chunk per thread; the threads count the digit of their chunk,
+// an exclusive scan over (digit, chunk) gives every chunk its output offsets
+// and the threads scatter their chunks in parallel. The scatter keeps the
+// order within each chunk and the chunks in sequence, so every pass is stable
+// and the result is the same for any thread count. Passes whose digit is the
+// same for all keys (e.g. the exponent of prices within one binade) are
+// skipped. Needs a scratch buffer of n values.
+template <typename T>
+void radixSort(T* data, std::size_t n, int num_threads) {
+    if (n < kRadixMinSize) {
+        std::sort(data, data + n);
+        return;
+    }
+    using Key = RadixKey<T>;
+    const std::size_t kBuckets = std::size_t(1) << kRadixDigitBits;
+    const int key_bits = 8 * sizeof(Key);
+    const int chunks =
+        static_cast<int>(std::max<std::size_t>(1, std::min<std::size_t>(num_threads, n / kRadixMinSize)));
+    auto chunkBegin = [n, chunks](int c) { return n * c / chunks; };
+
+    std::vector<T> scratch(n);
+    T* src = data;
+    T* dst = scratch.data();
+    std::vector<std::size_t> counts(chunks * kBuckets);
+    for (int shift = 0; shift < key_bits; shift += kRadixDigitBits) {
+        const Key mask = static_cast<Key>(kBuckets - 1);
+        parallelFor(chunks, chunks, [&](int c, int) {
+            std::size_t* count = &counts[c * kBuckets];
+            std::fill(count, count + kBuckets, 0);
+            for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                ++count[(radixKey(src[i]) >> shift) & mask];
+            }
+        });
+
+        // Offsets in (digit, chunk) order; a digit shared by all keys means
+        // the pass would not move anything
+        std::size_t offset = 0;
+        bool trivial = false;
+        for (std::size_t b = 0; b < kBuckets && !trivial; ++b) {
+            std::size_t digit_total = 0;
+            for (int c = 0; c < chunks; ++c) {
+                std::size_t count = counts[c * kBuckets + b];
+                counts[c * kBuckets + b] = offset;
+                offset += count;
+                digit_total += count;
+            }
+            trivial = digit_total == n;
+        }
+        if (trivial) continue;
+
+        parallelFor(chunks, chunks, [&](int c, int) {
+            std::size_t* next = &counts[c * kBuckets];
+            for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                dst[next[(radixKey(src[i]) >> shift) & mask]++] = src[i];
+            }
+        });
+        std::swap(src, dst);
+    }
+    if (src != data) {
+        parallelFor(chunks, chunks, [&](int c, int) {
+            std::copy(src + chunkBegin(c), src + chunkBegin(c + 1), data + chunkBegin(c));
+        });
+    }
+}
+
+template <typename T>
+void radixSort(std::vector<T>& values, int num_threads) {
+    radixSort(values.data(), values.size(), num_threads);
+}
+
+// Out-of-core sort of a file of raw native-endian doubles into another file,
+// holding at most about memory_bytes of samples in memory (plus a scratch
+// copy of the same size during in-memory sorts). An MSD radix partition on
+// 16-bit digits of the keys splits the input into bucket files that each fit
+// in memory: one pass counts the digits, adjacent digits are grouped into
+// buckets of at most the budget, a second pass scatters the samples to the
+// bucket files, and the buckets are then sorted in memory with radixSort and
+// appended in order. A single digit holding more samples than the budget is
+// partitioned again on the next 16 bits; once all 64 bits agree the bucket
+// holds copies of one value and is streamed to the output unsorted, so the
+// budget holds for any distribution. Temporary files go to temp_dir and are
+// removed.
+class ExternalRadixSorter {
+public:
+    ExternalRadixSorter(std::size_t memory_bytes, int num_threads, std::string temp_dir)
+        : budget_(std::max<std::size_t>(memory_bytes / sizeof(double), 1)), num_threads_(num_threads),
+          temp_dir_(std::move(temp_dir)) {}
+
+    // Returns the number of samples sorted
+    std::uint64_t sort(const std::string& input, const std::string& output) {
+        std::uint64_t count = sampleCount(input);
+        std::ofstream out(output, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("cannot write " + output);
+        sortFile(input, count, 64 - kPartitionBits, out);
+        out.close();
+        if (!out) throw std::runtime_error("cannot write " + output);
+        return count;
+    }
+
+    // Deepest partition level and number of bucket files used by the last
+    // sort, and the most samples it held in memory at once
+    int depth() const { return max_depth_; }
+    std::size_t bucketFiles() const { return bucket_files_; }
+    std::size_t peakValues() const { return peak_values_; }
+
+private:
+    static const int kPartitionBits = 16;
+    static const std::size_t kIoValues = 1 << 16;  // Values per read or per bucket write buffer
+
+    static std::uint64_t sampleCount(const std::string& path) {
+        std::error_code error;
+        std::uintmax_t bytes = std::filesystem::file_size(path, error);
+        if (error) throw std::runtime_error("cannot open " + path);
+        if (bytes % sizeof(double) != 0) throw std::runtime_error(path + " is not a file of doubles");
+        return bytes / sizeof(double);
+    }
+
+    // Call fn(values, n) for consecutive pieces of the file
+    template <typename Fn>
+    static void readFile(const std::string& path, Fn fn) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("cannot open " + path);
+        std::vector<double> buffer(kIoValues);
+        while (in) {
+            in.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(double));
+            std::size_t n = in.gcount() / sizeof(double);
+            if (n == 0) break;
+            fn(buffer.data(), n);
+        }
+    }
+
+    static std::size_t digit(double value, int shift) {
+        return static_cast<std::size_t>((radixKey(value) >> shift) & ((1u << kPartitionBits) - 1));
+    }
+
+    // Append the sorted samples of a file holding count doubles to out. All
+    // keys in the file agree on the bits above shift + kPartitionBits.
+    void sortFile(const std::string& path, std::uint64_t count, int shift, std::ofstream& out, int depth = 0) {
+        max_depth_ = std::max(max_depth_, depth);
+        if (shift < 0) {
+            // Every key in the file is identical (all digits agree), so it is
+            // already sorted; copy it through without holding it in memory
+            readFile(path, [&](const double* v, std::size_t n) {
+                out.write(reinterpret_cast<const char*>(v), n * sizeof(double));
+            });
+            return;
+        }
+        if (count <= budget_) {
+            std::vector<double> values;
+            values.reserve(count);
+            readFile(path, [&](const double* v, std::size_t n) { values.insert(values.end(), v, v + n); });
+            peak_values_ = std::max(peak_values_, values.size());
+            radixSort(values, num_threads_);
+            out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+            return;
+        }
+
+        // Count the digits, then group adjacent digits in key order
+        const std::size_t kDigits = std::size_t(1) << kPartitionBits;
+        std::vector<std::uint64_t> digit_counts(kDigits, 0);
+        readFile(path, [&](const double* v, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) ++digit_counts[digit(v[i], shift)];
+        });
+        // into buckets of at most the budget. Only a bucket of a single digit
+        // can exceed it.
+        std::vector<std::size_t> bucket_of(kDigits, 0);
+        std::vector<std::uint64_t> bucket_counts;
+        for (std::size_t d = 0; d < kDigits; ++d) {
+            std::uint64_t c = digit_counts[d];
+            if (c == 0) continue;
+            if (bucket_counts.empty() || bucket_counts.back() + c > budget_) {
+                bucket_counts.push_back(c);
+            } else {
+                bucket_counts.back() += c;
+            }
+            bucket_of[d] = bucket_counts.size() - 1;
+        }
+
+        // Scatter to one file per bucket through buffered writers
+        std::vector<std::string> bucket_paths(bucket_counts.size());
+        {
+            std::vector<std::ofstream> files(bucket_counts.size());
+            std::vector<std::vector<double>> buffers(bucket_counts.size());
+            for (std::size_t b = 0; b < bucket_counts.size(); ++b) {
+                bucket_paths[b] = temporaryPath();
+                files[b].open(bucket_paths[b], std::ios::binary | std::ios::trunc);
+                if (!files[b]) throw std::runtime_error("cannot create " + bucket_paths[b]);
+                buffers[b].reserve(std::min<std::uint64_t>(bucket_counts[b], kIoValues / 16));
+            }
+            auto flush = [&](std::size_t b) {
+                files[b].write(reinterpret_cast<const char*>(buffers[b].data()), buffers[b].size() * sizeof(double));
+                buffers[b].clear();
+            };
+            readFile(path, [&](const double* v, std::size_t n) {
+                for (std::size_t i = 0; i < n; ++i) {
+                    std::size_t b = bucket_of[digit(v[i], shift)];
+                    buffers[b].push_back(v[i]);
+                    if (buffers[b].size() == buffers[b].capacity()) flush(b);
+                }
+            });
+            for (std::size_t b = 0; b < bucket_counts.size(); ++b) {
+                flush(b);
+                files[b].close();
+                if (!files[b]) throw std::runtime_error("cannot write " + bucket_paths[b]);
+            }
+        }
+
+        // Buckets in key order; an oversized digit is split on the next digit
+        for (std::size_t b = 0; b < bucket_counts.size(); ++b) {
+            int next_shift = bucket_counts[b] > budget_ ? shift - kPartitionBits : shift;
+            sortFile(bucket_paths[b], bucket_counts[b], next_shift, out, depth + 1);
+            std::filesystem::remove(bucket_paths[b]);
+        }
+    }
+
+    std::string temporaryPath() {
+        ++bucket_files_;
+        return (std::filesystem::path(temp_dir_) /
+                ("mc_radix_bucket_" + std::to_string(tag_) + "_" + std::to_string(bucket_files_) + ".bin"))
+            .string();
+    }
+
+    std::size_t budget_;  // Samples held in memory at once
+    int num_threads_;
+    std::string temp_dir_;
+    int max_depth_ = 0;
+    std::size_t bucket_files_ = 0;
+    std::size_t peak_values_ = 0;
+    std::uint32_t tag_ = std::random_device{}();  // Keeps the file names of concurrent sorts apart
+};
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,83 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+
+// 64-bit FNV-1a hash
+inline std::uint64_t fnv1a64(const std::string& data) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Content-addressed cache of run results in a local directory. An entry is
+// addressed by the hash of a canonical key string describing everything that
+// determines the result; the key itself is stored as the first line of the
+// entry so that hash collisions are detected instead of returning wrong data.
+// Entries are written to a temporary file and renamed into place, so
+// concurrent jobs never observe a partially written entry.
+class ResultCache {
+public:
+    explicit ResultCache(std::string directory) : directory_(std::move(directory)) {}
+
+    // Path of the file holding the given kind of data ("stats", "paths", ...) for key
+    std::string entryPath(const std::string& key, const std::string& kind) const {
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << fnv1a64(key) << "." << kind;
+        return (std::filesystem::path(directory_) / name.str()).string();
+    }
+
+    // Read the entry for key into contents; false on a miss
+    bool lookup(const std::string& key, std::string& contents) const {
+        std::ifstream in(entryPath(key, "stats"), std::ios::binary);
+        std::string stored_key;
+        if (!in || !std::getline(in, stored_key) || stored_key != key) return false;
+        std::ostringstream rest;
+        rest << in.rdbuf();
+        contents = rest.str();
+        return true;
+    }
+
+    bool store(const std::string& key, const std::string& contents) const {
+        return writeAtomically(entryPath(key, "stats"), [&](std::ostream& out) { out << key << "\n" << contents; });
+    }
+
+    // Write additional data (e.g. binary paths) next to the entry for key;
+    // write(out) streams the data so large payloads are never copied
+    template <typename Writer>
+    bool storeData(const std::string& key, const std::string& kind, Writer write) const {
+        return writeAtomically(entryPath(key, kind), write);
+    }
+
+private:
+    template <typename Writer>
+    bool writeAtomically(const std::string& path, Writer write) const {
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+        std::string temporary = path + ".tmp" + std::to_string(std::random_device{}());
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            write(out);
+            if (!out) {
+                out.close();
+                std::filesystem::remove(temporary, error);
+                return false;
+            }
+        }
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+
+    std::string directory_;
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,352 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Random number engines. Besides the standard UniformRandomBitGenerator
+// interface (so they work with <random> distributions) every engine has
+//   fill(out, n)  - bulk generation of n raw outputs
+//   discard(n)    - skip n outputs (O(1) or O(log n) except for MT19937)
+// and xoshiro256** also has jump(), which skips 2^128 outputs.
+
+inline std::uint64_t rotl64(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+// xoshiro256** (Blackman and Vigna): 256-bit state, period 2^256 - 1
+class Xoshiro256StarStar {
+public:
+    using result_type = std::uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit Xoshiro256StarStar(std::seed_seq& seq) {
+        std::uint32_t words[8];
+        seq.generate(words, words + 8);
+        for (int i = 0; i < 4; ++i) s_[i] = (std::uint64_t(words[2 * i]) << 32) | words[2 * i + 1];
+        if ((s_[0] | s_[1] | s_[2] | s_[3]) == 0) s_[0] = 1;  // The all-zero state is a fixed point
+    }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl64(s_[1] * 5, 7) * 9;
+        const std::uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl64(s_[3], 45);
+        return result;
+    }
+
+    void fill(result_type* out, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) out[i] = (*this)();
+    }
+
+    // Equivalent to 2^128 calls; gives non-overlapping subsequences
+    void jump() {
+        static const std::uint64_t kJump[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa,
+                                              0x39abdc4529b1661c};
+        std::uint64_t t[4] = {0, 0, 0, 0};
+        for (std::uint64_t word : kJump) {
+            for (int b = 0; b < 64; ++b) {
+                if (word & (std::uint64_t(1) << b)) {
+                    for (int i = 0; i < 4; ++i) t[i] ^= s_[i];
+                }
+                (*this)();
+            }
+        }
+        for (int i = 0; i < 4; ++i) s_[i] = t[i];
+    }
+
+    void discard(unsigned long long n) {
+        for (; n > 0; --n) (*this)();
+    }
+
+private:
+    std::uint64_t s_[4];
+};
+
+// Unsigned 128-bit arithmetic for PCG64: the compiler's __int128 where it
+// exists, otherwise two 64-bit halves (e.g. MSVC)
+struct Uint128 {
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+};
+
+inline Uint128 add128(Uint128 a, Uint128 b) {
+    Uint128 r;
+    r.lo = a.lo + b.lo;
+    r.hi = a.hi + b.hi + (r.lo < a.lo);
+    return r;
+}
+
+// Full 64 x 64 -> 128-bit product
+inline Uint128 mulWide64(std::uint64_t a, std::uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return {static_cast<std::uint64_t>(product >> 64), static_cast<std::uint64_t>(product)};
+#else
+    std::uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32, b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+    std::uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    std::uint64_t middle = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+    return {hi_hi + (hi_lo >> 32) + (middle >> 32), (middle << 32) | (lo_lo & 0xFFFFFFFFu)};
+#endif
+}
+
+// Product modulo 2^128
+inline Uint128 mul128(Uint128 a, Uint128 b) {
+    Uint128 r = mulWide64(a.lo, b.lo);
+    r.hi += a.lo * b.hi + a.hi * b.lo;
+    return r;
+}
+
+// PCG64 (O'Neill): 128-bit LCG with the XSL-RR output permutation; each
+// odd increment selects an independent stream
+class Pcg64 {
+public:
+    using result_type = std::uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit Pcg64(std::seed_seq& seq) {
+        std::uint32_t words[8];
+        seq.generate(words, words + 8);
+        Uint128 seed{(std::uint64_t(words[0]) << 32) | words[1], (std::uint64_t(words[2]) << 32) | words[3]};
+        Uint128 stream{(std::uint64_t(words[4]) << 32) | words[5], (std::uint64_t(words[6]) << 32) | words[7]};
+        increment_ = {(stream.hi << 1) | (stream.lo >> 63), (stream.lo << 1) | 1};
+        state_ = {};
+        step();
+        state_ = add128(state_, seed);
+        step();
+    }
+
+    result_type operator()() {
+        step();
+        std::uint64_t xored = state_.hi ^ state_.lo;
+        int rotation = static_cast<int>(state_.hi >> 58);
+        return (xored >> rotation) | (xored << ((-rotation) & 63));
+    }
+
+    void fill(result_type* out, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) out[i] = (*this)();
+    }
+
+    // Skip n outputs in O(log n) (Brown, "Random number generation with
+    // arbitrary strides")
+    void discard(unsigned long long n) {
+        Uint128 acc_mult{0, 1}, acc_plus{0, 0}, cur_mult = multiplier(), cur_plus = increment_;
+        for (unsigned long long delta = n; delta > 0; delta >>= 1) {
+            if (delta & 1) {
+                acc_mult = mul128(acc_mult, cur_mult);
+                acc_plus = add128(mul128(acc_plus, cur_mult), cur_plus);
+            }
+            cur_plus = mul128(add128(cur_mult, Uint128{0, 1}), cur_plus);
+            cur_mult = mul128(cur_mult, cur_mult);
+        }
+        state_ = add128(mul128(acc_mult, state_), acc_plus);
+    }
+
+private:
+    static Uint128 multiplier() { return {0x2360ED051FC65DA4ull, 0x4385DF649FCCF645ull}; }
+
+    void step() { state_ = add128(mul128(state_, multiplier()), increment_); }
+
+    Uint128 state_;
+    Uint128 increment_;
+};
+
+// Philox4x32-10 (Salmon et al.): counter-based, so any position of the
+// sequence can be reached directly. Each 128-bit counter gives four 32-bit
+// words, returned as two 64-bit outputs.
+class Philox4x32 {
+public:
+    using result_type = std::uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    // The key selects the sequence and stream sets the high counter words,
+    // so different streams never overlap
+    Philox4x32(std::uint64_t key, std::uint64_t stream)
+        : key_{static_cast<std::uint32_t>(key), static_cast<std::uint32_t>(key >> 32)},
+          stream_(stream) {}
+
+    result_type operator()() {
+        if (buffered_ == 0) {
+            generate(position_++, buffer_);
+            buffered_ = 2;
+        }
+        return buffer_[2 - buffered_--];
+    }
+
+    void fill(result_type* out, std::size_t n) {
+        std::size_t i = 0;
+        while (i < n && buffered_ > 0) out[i++] = (*this)();
+        for (; i + 2 <= n; i += 2) generate(position_++, out + i);
+        if (i < n) out[i] = (*this)();
+    }
+
+    void discard(unsigned long long n) {
+        while (n > 0 && buffered_ > 0) {
+            (*this)();
+            --n;
+        }
+        position_ += n / 2;
+        if (n % 2) (*this)();
+    }
+
+private:
+    static void mulhilo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo) {
+        std::uint64_t product = std::uint64_t(a) * b;
+        hi = static_cast<std::uint32_t>(product >> 32);
+        lo = static_cast<std::uint32_t>(product);
+    }
+
+    void generate(std::uint64_t counter, result_type* out) const {
+        std::uint32_t c[4] = {static_cast<std::uint32_t>(counter), static_cast<std::uint32_t>(counter >> 32),
+                              static_cast<std::uint32_t>(stream_), static_cast<std::uint32_t>(stream_ >> 32)};
+        std::uint32_t k[2] = {key_[0], key_[1]};
+        for (int round = 0; round < 10; ++round) {
+            std::uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(0xD2511F53u, c[0], hi0, lo0);
+            mulhilo(0xCD9E8D57u, c[2], hi1, lo1);
+            c[0] = hi1 ^ c[1] ^ k[0];
+            c[1] = lo1;
+            c[2] = hi0 ^ c[3] ^ k[1];
+            c[3] = lo0;
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        out[0] = (std::uint64_t(c[1]) << 32) | c[0];
+        out[1] = (std::uint64_t(c[3]) << 32) | c[2];
+    }
+
+    std::uint32_t key_[2];
+    std::uint64_t stream_;
+    std::uint64_t position_ = 0;  // Next counter
+    result_type buffer_[2];
+    int buffered_ = 0;
+};
+
+// MT19937 with the same bulk interface
+class Mt19937 {
+public:
+    using result_type = std::mt19937::result_type;
+    static constexpr result_type min() { return std::mt19937::min(); }
+    static constexpr result_type max() { return std::mt19937::max(); }
+
+    explicit Mt19937(std::seed_seq& seq) : engine_(seq) {}
+
+    result_type operator()() { return engine_(); }
+
+    void fill(result_type* out, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) out[i] = engine_();
+    }
+
+    void discard(unsigned long long n) { engine_.discard(n); }
+
+private:
+    std::mt19937 engine_;
+};
+
+enum class RngEngine { Mt19937, Xoshiro256, Pcg64, Philox4x32 };
+
+// Source of standard normal shocks. The simulation kernels draw a whole
+// step's worth of shocks at once, so the engine is chosen at run time with
+// one virtual call per batch and the per-variate loop stays inlined.
+class NormalStream {
+public:
+    virtual ~NormalStream() = default;
+    virtual void fill(double* out, std::size_t n) = 0;
+    double next() {
+        double z;
+        fill(&z, 1);
+        return z;
+    }
+};
+
+// Normals from an engine's bulk output: raw words are drawn with fill() in
+// batches, turned into uniforms with 53 random bits (one 64-bit word or two
+// 32-bit MT19937 words each) and paired by Marsaglia's polar method, which
+// needs no trigonometric functions. The second normal of a pair that does not
+// fit is kept for the next call.
+template <typename Engine>
+class EngineNormalStream : public NormalStream {
+public:
+    explicit EngineNormalStream(Engine engine) : engine_(std::move(engine)), words_(kBatchWords) {}
+
+    void fill(double* out, std::size_t n) override {
+        std::size_t i = 0;
+        if (n > 0 && has_spare_) {
+            out[i++] = spare_;
+            has_spare_ = false;
+        }
+        while (i < n) {
+            if (next_ == kBatchWords) {
+                engine_.fill(words_.data(), kBatchWords);
+                next_ = 0;
+            }
+            // A point in the unit disc (accepted with probability pi/4)
+            double u = 2.0 * uniform(&words_[next_]) - 1.0;
+            double v = 2.0 * uniform(&words_[next_ + kWordsPerUniform]) - 1.0;
+            next_ += 2 * kWordsPerUniform;
+            double s = u * u + v * v;
+            if (s >= 1.0 || s == 0.0) continue;
+            double f = std::sqrt(-2.0 * std::log(s) / s);
+            out[i++] = u * f;
+            if (i < n) {
+                out[i++] = v * f;
+            } else {
+                spare_ = v * f;
+                has_spare_ = true;
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t kWordsPerUniform = Engine::max() > 0xFFFFFFFFu ? 1 : 2;
+    static constexpr std::size_t kBatchWords = 512 * kWordsPerUniform;  // Whole pairs of uniforms
+
+    static double uniform(const typename Engine::result_type* w) {
+        std::uint64_t bits;
+        if constexpr (kWordsPerUniform == 1) {
+            bits = static_cast<std::uint64_t>(w[0]) >> 11;
+        } else {
+            bits = (static_cast<std::uint64_t>(w[0]) << 21) | (static_cast<std::uint64_t>(w[1]) >> 11);
+        }
+        return bits * 0x1.0p-53;
+    }
+
+    Engine engine_;
+    std::vector<typename Engine::result_type> words_;
+    std::size_t next_ = kBatchWords;  // First unused word of the batch
+    double spare_ = 0.0;
+    bool has_spare_ = false;
+};
+
+// Engine for stream `stream` of `seed`. Streams of the seeded engines are
+// derived with std::seed_seq; Philox uses the stream as its high counter.
+template <typename Fn>
+auto withEngine(RngEngine engine, std::uint64_t seed, std::uint64_t stream, Fn fn) {
+    std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                      static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)};
+    switch (engine) {
+        case RngEngine::Xoshiro256: return fn(Xoshiro256StarStar(seq));
+        case RngEngine::Pcg64: return fn(Pcg64(seq));
+        case RngEngine::Philox4x32: return fn(Philox4x32(seed, stream));
+        default: return fn(Mt19937(seq));
+    }
+}
+
+inline std::unique_ptr<NormalStream> makeNormalStream(RngEngine engine, std::uint64_t seed, std::uint64_t stream) {
+    return withEngine(engine, seed, stream, [](auto e) -> std::unique_ptr<NormalStream> {
+        return std::make_unique<EngineNormalStream<decltype(e)>>(std::move(e));
+    });
+}
+
+#endif // RNG_H
@@ -0,0 +1,195 @@
+#ifndef SDE_H
+#define SDE_H
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+// Expression templates for the coefficients of one-factor SDEs
+//     dX = a(t, X) dt + b(t, X) dW
+// Coefficients are written as ordinary expressions in the state variable
+// (stateVar()) and time (timeVar()), e.g.
+//     auto drift = kappa * (theta - stateVar());
+//     auto diffusion = sigma * sqrtPos(stateVar());
+// Every expression is its own type, so a scheme instantiated with it compiles
+// to straight-line code that the compiler can inline and vectorize, with no
+// virtual call per step. Expressions also know their derivative with respect
+// to X (d_dx), which the Milstein scheme needs.
+
+struct ExprConst {
+    double value;
+    double eval(double, double) const { return value; }
+};
+
+struct ExprState {
+    double eval(double, double x) const { return x; }
+};
+
+struct ExprTime {
+    double eval(double t, double) const { return t; }
+};
+
+template <typename E> struct IsExpr : std::false_type {};
+template <> struct IsExpr<ExprConst> : std::true_type {};
+template <> struct IsExpr<ExprState> : std::true_type {};
+template <> struct IsExpr<ExprTime> : std::true_type {};
+
+template <typename A, typename B> struct ExprAdd {
+    A a; B b;
+    double eval(double t, double x) const { return a.eval(t, x) + b.eval(t, x); }
+};
+template <typename A, typename B> struct ExprSub {
+    A a; B b;
+    double eval(double t, double x) const { return a.eval(t, x) - b.eval(t, x); }
+};
+template <typename A, typename B> struct ExprMul {
+    A a; B b;
+    double eval(double t, double x) const { return a.eval(t, x) * b.eval(t, x); }
+};
+template <typename A, typename B> struct ExprDiv {
+    A a; B b;
+    double eval(double t, double x) const { return a.eval(t, x) / b.eval(t, x); }
+};
+// Square root of max(a, 0), the usual fix for square-root diffusions
+template <typename A> struct ExprSqrtPos {
+    A a;
+    double eval(double t, double x) const { return std::sqrt(std::max(a.eval(t, x), 0.0)); }
+};
+template <typename A> struct ExprExp {
+    A a;
+    double eval(double t, double x) const { return std::exp(a.eval(t, x)); }
+};
+// max(a, 0)^p for a constant exponent p
+template <typename A> struct ExprPow {
+    A a; double p;
+    double eval(double t, double x) const { return std::pow(std::max(a.eval(t, x), 0.0), p); }
+};
+// Derivative of max(a, 0)^p with respect to a: p a^(p-1), and zero where a
+// is clamped (a^(p-1) would be infinite there for p < 1)
+template <typename A> struct ExprPowSlope {
+    A a; double p;
+    double eval(double t, double x) const {
+        double y = a.eval(t, x);
+        return y > 0.0 ? p * std::pow(y, p - 1.0) : 0.0;
+    }
+};
+// Derivative of sqrt(max(a, 0)) with respect to a: 1 / (2 sqrt(a)), and zero
+// where a is clamped
+template <typename A> struct ExprSqrtPosSlope {
+    A a;
+    double eval(double t, double x) const {
+        double y = a.eval(t, x);
+        return y > 0.0 ? 0.5 / std::sqrt(y) : 0.0;
+    }
+};
+
+template <typename A, typename B> struct IsExpr<ExprAdd<A, B>> : std::true_type {};
+template <typename A, typename B> struct IsExpr<ExprSub<A, B>> : std::true_type {};
+template <typename A, typename B> struct IsExpr<ExprMul<A, B>> : std::true_type {};
+template <typename A, typename B> struct IsExpr<ExprDiv<A, B>> : std::true_type {};
+template <typename A> struct IsExpr<ExprSqrtPos<A>> : std::true_type {};
+template <typename A> struct IsExpr<ExprExp<A>> : std::true_type {};
+template <typename A> struct IsExpr<ExprPow<A>> : std::true_type {};
+template <typename A> struct IsExpr<ExprPowSlope<A>> : std::true_type {};
+template <typename A> struct IsExpr<ExprSqrtPosSlope<A>> : std::true_type {};
+
+// Lift doubles to constants so that expressions like 0.5 * stateVar() work
+inline ExprConst toExpr(double value) { return {value}; }
+template <typename E, typename = std::enable_if_t<IsExpr<E>::value>>
+E toExpr(const E& e) { return e; }
+
+template <typename A, typename B>
+using EnableIfExprOperands = std::enable_if_t<(IsExpr<A>::value || IsExpr<B>::value) &&
+                                              (IsExpr<A>::value || std::is_arithmetic<A>::value) &&
+                                              (IsExpr<B>::value || std::is_arithmetic<B>::value)>;
+
+template <typename A, typename B, typename = EnableIfExprOperands<A, B>>
+auto operator+(const A& a, const B& b) {
+    return ExprAdd<decltype(toExpr(a)), decltype(toExpr(b))>{toExpr(a), toExpr(b)};
+}
+template <typename A, typename B, typename = EnableIfExprOperands<A, B>>
+auto operator-(const A& a, const B& b) {
+    return ExprSub<decltype(toExpr(a)), decltype(toExpr(b))>{toExpr(a), toExpr(b)};
+}
+template <typename A, typename B, typename = EnableIfExprOperands<A, B>>
+auto operator*(const A& a, const B& b) {
+    return ExprMul<decltype(toExpr(a)), decltype(toExpr(b))>{toExpr(a), toExpr(b)};
+}
+template <typename A, typename B, typename = EnableIfExprOperands<A, B>>
+auto operator/(const A& a, const B& b) {
+    return ExprDiv<decltype(toExpr(a)), decltype(toExpr(b))>{toExpr(a), toExpr(b)};
+}
+
+inline ExprState stateVar() { return {}; }
+inline ExprTime timeVar() { return {}; }
+template <typename A, typename = std::enable_if_t<IsExpr<A>::value>>
+ExprSqrtPos<A> sqrtPos(const A& a) { return {a}; }
+template <typename A, typename = std::enable_if_t<IsExpr<A>::value>>
+ExprExp<A> expOf(const A& a) { return {a}; }
+template <typename A, typename = std::enable_if_t<IsExpr<A>::value>>
+ExprPow<A> powPos(const A& a, double p) { return {a, p}; }
+
+// Symbolic derivative with respect to the state variable
+inline ExprConst d_dx(const ExprConst&) { return {0.0}; }
+inline ExprConst d_dx(const ExprState&) { return {1.0}; }
+inline ExprConst d_dx(const ExprTime&) { return {0.0}; }
+template <typename A, typename B> auto d_dx(const ExprAdd<A, B>& e) { return d_dx(e.a) + d_dx(e.b); }
+template <typename A, typename B> auto d_dx(const ExprSub<A, B>& e) { return d_dx(e.a) - d_dx(e.b); }
+template <typename A, typename B> auto d_dx(const ExprMul<A, B>& e) {
+    return d_dx(e.a) * e.b + e.a * d_dx(e.b);
+}
+template <typename A, typename B> auto d_dx(const ExprDiv<A, B>& e) {
+    return (d_dx(e.a) * e.b - e.a * d_dx(e.b)) / (e.b * e.b);
+}
+template <typename A> auto d_dx(const ExprSqrtPos<A>& e) {
+    return ExprSqrtPosSlope<A>{e.a} * d_dx(e.a);
+}
+template <typename A> auto d_dx(const ExprExp<A>& e) { return e * d_dx(e.a); }
+template <typename A> auto d_dx(const ExprPow<A>& e) {
+    return ExprPowSlope<A>{e.a, e.p} * d_dx(e.a);
+}
+
+// Euler-Maruyama: X += a dt + b dW
+template <typename Drift, typename Diffusion>
+struct EulerScheme {
+    Drift a;
+    Diffusion b;
+
+    double step(double t, double x, double dt, double dW) const {
+        return x + a.eval(t, x) * dt + b.eval(t, x) * dW;
+    }
+};
+
+// Milstein: X += a dt + b dW + 1/2 b b' (dW^2 - dt), strong order 1
+template <typename Drift, typename Diffusion>
+struct MilsteinScheme {
+    Drift a;
+    Diffusion b;
+    decltype(d_dx(std::declval<Diffusion>())) db;
+
+    MilsteinScheme(const Drift& drift, const Diffusion& diffusion) : a(drift), b(diffusion), db(d_dx(diffusion)) {}
+
+    double step(double t, double x, double dt, double dW) const {
+        double bx = b.eval(t, x);
+        return x + a.eval(t, x) * dt + bx * dW + 0.5 * bx * db.eval(t, x) * (dW * dW - dt);
+    }
+};
+
+template <typename Drift, typename Diffusion>
+EulerScheme<Drift, Diffusion> eulerScheme(const Drift& a, const Diffusion& b) { return {a, b}; }
+
+template <typename Drift, typename Diffusion>
+MilsteinScheme<Drift, Diffusion> milsteinScheme(const Drift& a, const Diffusion& b) { return {a, b}; }
+
+// Advance n states by one step of length dt from time t using standard
+// normal shocks z. The scheme is a template parameter, so the loop body is
+// fully inlined.
+template <typename Scheme>
+void advanceSde(const Scheme& scheme, double* x, const double* z, int n, double t, double dt) {
+    const double sqrt_dt = std::sqrt(dt);
+    for (int j = 0; j < n; ++j) {
+        x[j] = scheme.step(t, x[j], dt, sqrt_dt * z[j]);
+    }
+}
+
+#endif // SDE_H
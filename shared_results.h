@@ -0,0 +1,244 @@
+#ifndef SHARED_RESULTS_H
+#define SHARED_RESULTS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+// POSIX shared memory (shm_open/mmap); elsewhere the publisher only reports
+// that the feature is unavailable
+#if defined(__unix__) || defined(__APPLE__)
+#define MC_SHARED_MEMORY 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Results published in a POSIX shared-memory segment (shm_open), so other
+// processes on the host can read them in place while the run progresses.
+//
+// Layout: a SharedResultsHeader, then one ready flag per block of paths
+// (flags_offset), then the prices of all paths, path-major with steps + 1
+// doubles per path (paths_offset). A block's flag is set with release
+// semantics after its prices are written, so a reader that sees the flag
+// (acquire) sees the whole block. The statistics are guarded by a seqlock:
+// the writer makes `sequence` odd, updates them and makes it even again; a
+// reader retries until it reads the same even sequence before and after.
+// `version` is written last when the segment is created; readers must
+// check it before trusting the layout.
+
+const char kSharedResultsMagic[8] = {'M', 'C', 'R', 'E', 'S', 'U', 'L', 'T'};
+const std::uint32_t kSharedResultsVersion = 1;
+
+enum SharedStatistic {
+    kSharedPaths,         // Paths included in the statistics
+    kSharedMean,
+    kSharedMeanStdError,
+    kSharedStdDev,
+    kSharedMin,
+    kSharedMax,
+    kSharedPercentile5,
+    kSharedPercentile95,
+    kSharedStatisticCount
+};
+
+struct SharedResultsHeader {
+    char magic[8];
+    std::atomic<std::uint32_t> version;  // 0 while the segment is being initialized
+    std::uint32_t header_bytes;
+    std::uint64_t num_paths;
+    std::uint64_t steps;
+    std::uint64_t paths_per_block;
+    std::uint64_t num_blocks;     // 0 when only statistics are published
+    std::uint64_t flags_offset;   // Byte offset of the std::atomic<std::uint32_t> block flags
+    std::uint64_t paths_offset;   // Byte offset of the prices
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<double> statistics[kSharedStatisticCount];
+    std::atomic<std::uint32_t> blocks_ready;  // Number of blocks published so far
+    std::atomic<std::uint32_t> complete;      // 1 once the statistics are final
+};
+
+static_assert(std::atomic<double>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared-memory results need lock-free atomics");
+
+#ifdef MC_SHARED_MEMORY
+const bool kSharedResultsSupported = true;
+
+// Writer side: creates (or replaces) the segment. The segment outlives the
+// process so consumers can read it after the run; remove it with
+// shm_unlink or by deleting /dev/shm/<name>.
+class SharedResultsPublisher {
+public:
+    SharedResultsPublisher(const std::string& name, int num_paths, int steps, int paths_per_block,
+                           bool with_paths) {
+        std::uint64_t num_blocks = with_paths ? (num_paths + paths_per_block - 1) / paths_per_block : 0;
+        std::uint64_t flags_offset = align(sizeof(SharedResultsHeader));
+        std::uint64_t paths_offset = align(flags_offset + num_blocks * sizeof(std::atomic<std::uint32_t>));
+        bytes_ = paths_offset + (with_paths ? std::uint64_t(num_paths) * (steps + 1) * sizeof(double) : 0);
+
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("cannot create shared memory segment " + name);
+        if (ftruncate(fd, bytes_) != 0) {
+            close(fd);
+            throw std::runtime_error("cannot size shared memory segment " + name);
+        }
+        void* memory = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) throw std::runtime_error("cannot map shared memory segment " + name);
+        base_ = static_cast<char*>(memory);
+
+        header_ = new (base_) SharedResultsHeader;
+        std::memcpy(header_->magic, kSharedResultsMagic, sizeof(kSharedResultsMagic));
+        header_->header_bytes = sizeof(SharedResultsHeader);
+        header_->num_paths = num_paths;
+        header_->steps = steps;
+        header_->paths_per_block = paths_per_block;
+        header_->num_blocks = num_blocks;
+        header_->flags_offset = flags_offset;
+        header_->paths_offset = paths_offset;
+        header_->sequence.store(0, std::memory_order_relaxed);
+        for (auto& value : header_->statistics) value.store(0.0, std::memory_order_relaxed);
+        header_->blocks_ready.store(0, std::memory_order_relaxed);
+        header_->complete.store(0, std::memory_order_relaxed);
+        flags_ = reinterpret_cast<std::atomic<std::uint32_t>*>(base_ + flags_offset);
+        for (std::uint64_t b = 0; b < num_blocks; ++b) new (&flags_[b]) std::atomic<std::uint32_t>(0);
+        paths_ = reinterpret_cast<double*>(base_ + paths_offset);
+        header_->version.store(kSharedResultsVersion, std::memory_order_release);
+    }
+
+    ~SharedResultsPublisher() { munmap(base_, bytes_); }
+
+    SharedResultsPublisher(const SharedResultsPublisher&) = delete;
+    SharedResultsPublisher& operator=(const SharedResultsPublisher&) = delete;
+
+    bool publishesPaths() const { return header_->num_blocks > 0; }
+
+    // Copy one path's prices[0..steps]; paths of a block may be written by
+    // one thread while other threads write other blocks
+    void writePath(int path, const double* prices) {
+        std::size_t stride = header_->steps + 1;
+        std::memcpy(paths_ + path * stride, prices, stride * sizeof(double));
+    }
+
+    // Make a block visible to readers once all its paths are written
+    void markBlockReady(int block) {
+        flags_[block].store(1, std::memory_order_release);
+        header_->blocks_ready.fetch_add(1, std::memory_order_release);
+    }
+
+    // Publish a consistent set of statistics (values[kSharedStatisticCount]);
+    // may be called repeatedly, e.g. for running updates
+    void publishStatistics(const double* values, bool final) {
+        std::uint64_t sequence = header_->sequence.load(std::memory_order_relaxed);
+        header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = 0; i < kSharedStatisticCount; ++i) {
+            header_->statistics[i].store(values[i], std::memory_order_relaxed);
+        }
+        header_->sequence.store(sequence + 2, std::memory_order_release);
+        if (final) header_->complete.store(1, std::memory_order_release);
+    }
+
+    std::size_t bytes() const { return bytes_; }
+
+private:
+    static std::uint64_t align(std::uint64_t offset) { return (offset + 63) / 64 * 64; }
+
+    char* base_ = nullptr;
+    std::size_t bytes_ = 0;
+    SharedResultsHeader* header_ = nullptr;
+    std::atomic<std::uint32_t>* flags_ = nullptr;
+    double* paths_ = nullptr;
+};
+
+// Reader side for consumers: maps the segment read-only and gives zero-copy
+// access to the published blocks
+class SharedResultsReader {
+public:
+    explicit SharedResultsReader(const std::string& name) {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) throw std::runtime_error("cannot open shared memory segment " + name);
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(SharedResultsHeader)) {
+            close(fd);
+            throw std::runtime_error("shared memory segment " + name + " is not initialized");
+        }
+        bytes_ = info.st_size;
+        void* memory = mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) throw std::runtime_error("cannot map shared memory segment " + name);
+        base_ = static_cast<const char*>(memory);
+        header_ = reinterpret_cast<const SharedResultsHeader*>(base_);
+        if (header_->version.load(std::memory_order_acquire) != kSharedResultsVersion ||
+            std::memcmp(header_->magic, kSharedResultsMagic, sizeof(kSharedResultsMagic)) != 0) {
+            munmap(const_cast<char*>(base_), bytes_);
+            throw std::runtime_error("shared memory segment " + name + " has an unknown format or version");
+        }
+    }
+
+    ~SharedResultsReader() { munmap(const_cast<char*>(base_), bytes_); }
+
+    SharedResultsReader(const SharedResultsReader&) = delete;
+    SharedResultsReader& operator=(const SharedResultsReader&) = delete;
+
+    const SharedResultsHeader& header() const { return *header_; }
+
+    // Consistent snapshot of the statistics; false if a writer kept
+    // interfering for max_attempts tries
+    bool readStatistics(double* values, int max_attempts = 1000) const {
+        for (int attempt = 0; attempt < max_attempts; ++attempt) {
+            std::uint64_t before = header_->sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            for (int i = 0; i < kSharedStatisticCount; ++i) {
+                values[i] = header_->statistics[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header_->sequence.load(std::memory_order_relaxed) == before) return true;
+        }
+        return false;
+    }
+
+    bool complete() const { return header_->complete.load(std::memory_order_acquire) != 0; }
+
+    bool blockReady(int block) const {
+        const auto* flags = reinterpret_cast<const std::atomic<std::uint32_t>*>(base_ + header_->flags_offset);
+        return flags[block].load(std::memory_order_acquire) != 0;
+    }
+
+    // Prices[0..steps] of a path; valid once its block is ready
+    const double* path(int index) const {
+        const double* paths = reinterpret_cast<const double*>(base_ + header_->paths_offset);
+        return paths + static_cast<std::size_t>(index) * (header_->steps + 1);
+    }
+
+private:
+    const char* base_ = nullptr;
+    std::size_t bytes_ = 0;
+    const SharedResultsHeader* header_ = nullptr;
+};
+
+#else
+const bool kSharedResultsSupported = false;
+
+// Stand-in with the publisher's interface; constructing it always fails
+class SharedResultsPublisher {
+public:
+    SharedResultsPublisher(const std::string&, int, int, int, bool) {
+        throw std::runtime_error("shared-memory results are unsupported on this platform");
+    }
+
+    bool publishesPaths() const { return false; }
+    void writePath(int, const double*) {}
+    void markBlockReady(int) {}
+    void publishStatistics(const double*, bool) {}
+    std::size_t bytes() const { return 0; }
+};
+#endif
+
+#endif // SHARED_RESULTS_H
@@ -0,0 +1,98 @@
+#ifndef TERM_STRUCTURE_H
+#define TERM_STRUCTURE_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A parameter that varies with time (e.g. drift or volatility), given by
+// knots (times[k], values[k]) with increasing times. Between knots the value
+// is either held constant from the left knot (Step) or linearly interpolated
+// (Linear); before the first and after the last knot it is flat.
+//
+// Integrals over a time interval are exact for both interpolations, so step
+// coefficients derived from them do not depend on the step size.
+struct TermStructure {
+    enum class Interpolation { Step, Linear };
+
+    std::vector<double> times;
+    std::vector<double> values;
+    Interpolation interpolation = Interpolation::Step;
+
+    bool empty() const { return times.empty(); }
+
+    double valueAt(double t) const {
+        if (t <= times.front()) return values.front();
+        if (t >= times.back()) return values.back();
+        std::size_t k = std::upper_bound(times.begin(), times.end(), t) - times.begin() - 1;
+        if (interpolation == Interpolation::Step) return values[k];
+        double w = (t - times[k]) / (times[k + 1] - times[k]);
+        return values[k] + w * (values[k + 1] - values[k]);
+    }
+
+    // Integral of the value over [t0, t1]
+    double integral(double t0, double t1) const {
+        return integrate(t0, t1, [](double v0, double v1) { return 0.5 * (v0 + v1); });
+    }
+
+    // Integral of the squared value over [t0, t1]
+    double integralOfSquare(double t0, double t1) const {
+        return integrate(t0, t1, [](double v0, double v1) { return (v0 * v0 + v0 * v1 + v1 * v1) / 3.0; });
+    }
+
+private:
+    // Sum over the pieces of [t0, t1] between knots of length * mean(v0, v1),
+    // where the value runs linearly from v0 to v1 on the piece (v0 == v1 for
+    // Step interpolation) and mean is the exact average of the integrand
+    template <typename PieceMean>
+    double integrate(double t0, double t1, PieceMean mean) const {
+        double total = 0.0;
+        double a = t0;
+        while (a < t1) {
+            std::size_t k = std::upper_bound(times.begin(), times.end(), a) - times.begin();
+            double b = (k < times.size()) ? std::min(times[k], t1) : t1;
+            double v0, v1;
+            if (interpolation == Interpolation::Step || k == 0 || k == times.size()) {
+                v0 = v1 = valueAt(a);
+            } else {
+                v0 = valueAt(a);
+                v1 = valueAt(b);
+            }
+            total += (b - a) * mean(v0, v1);
+            a = b;
+        }
+        return total;
+    }
+};
+
+// Load a term structure from a file of "time,value" lines (time in years).
+// Blank lines and lines starting with '#' are ignored.
+inline TermStructure loadTermStructure(const std::string& path, TermStructure::Interpolation interpolation) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open term structure file " + path);
+
+    TermStructure curve;
+    curve.interpolation = interpolation;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        char* end = nullptr;
+        double t = std::strtod(line.c_str(), &end);
+        if (end == line.c_str() || *end != ',') throw std::runtime_error("invalid line in " + path + ": " + line);
+        const char* value_begin = end + 1;
+        double value = std::strtod(value_begin, &end);
+        if (end == value_begin) throw std::runtime_error("invalid line in " + path + ": " + line);
+        if (!curve.times.empty() && t <= curve.times.back()) {
+            throw std::runtime_error("times must be increasing in " + path);
+        }
+        curve.times.push_back(t);
+        curve.values.push_back(value);
+    }
+    if (curve.empty()) throw std::runtime_error("no knots in " + path);
+    return curve;
+}
+
+#endif // TERM_STRUCTURE_H
@@ -0,0 +1,496 @@
+// Unit tests for the header-only components: round trips and known values.
+// Run every group with no arguments, or one group by name (CTest registers
+// each group as its own test).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "barrier.h"
+#include "fast_exp.h"
+#include "lsm.h"
+#include "path_store.h"
+#include "price_index.h"
+#include "radix_sort.h"
+#include "rng.h"
+#include "sde.h"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);     \
+            ++failures;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                           \
+    do {                                                                                  \
+        double a_ = (actual), e_ = (expected), t_ = (tolerance);                          \
+        if (!(std::fabs(a_ - e_) <= t_)) {                                                \
+            std::printf("%s:%d: %s = %.17g, expected %.17g +- %g\n", __FILE__, __LINE__,  \
+                        #actual, a_, e_, t_);                                             \
+            ++failures;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+// A GBM path with daily steps from a fixed seed
+std::vector<double> gbmPath(int steps, double S0, double sigma, unsigned seed) {
+    std::mt19937_64 engine(seed);
+    std::normal_distribution<double> normal;
+    const double dt = 1.0 / 252;
+    std::vector<double> prices(steps + 1, S0);
+    for (int i = 1; i <= steps; ++i) {
+        prices[i] = prices[i - 1] * std::exp(-0.5 * sigma * sigma * dt + sigma * std::sqrt(dt) * normal(engine));
+    }
+    return prices;
+}
+
+void testPathStore() {
+    const int kPaths = 8, kSteps = 252;
+    const double kS0 = 100.0;
+    for (int bits : {8, 12, 16, 32}) {
+        CompressedPathStore store(kPaths, kSteps, kS0, bits);
+        std::vector<std::vector<double>> paths;
+        for (int p = 0; p < kPaths; ++p) {
+            paths.push_back(gbmPath(kSteps, kS0, 0.2 + 0.1 * p, p + 1));
+            store.storePath(p, paths[p].data());
+        }
+        // Every decoded price is within the advertised bound, and the final
+        // price summed from the codes matches the decoded path
+        const double bound = store.maxRelativeError();
+        CHECK(bound > 0.0);
+        std::vector<std::vector<double>> decoded = store.decodeBlock(0, kPaths);
+        CHECK(decoded.size() == static_cast<std::size_t>(kPaths));
+        for (int p = 0; p < kPaths; ++p) {
+            CHECK_NEAR(decoded[p][0], kS0, 1e-12 * kS0);
+            for (int i = 1; i <= kSteps; ++i) {
+                CHECK(std::fabs(decoded[p][i] / paths[p][i] - 1.0) <= bound * (1 + 1e-9));
+            }
+            CHECK_NEAR(store.finalPrice(p), decoded[p][kSteps], 1e-12 * decoded[p][kSteps]);
+        }
+    }
+
+    // 16 bits at 20% volatility and daily steps: about 1e-6 (see path_store.h)
+    CompressedPathStore store16(1, kSteps, kS0, 16);
+    std::vector<double> path = gbmPath(kSteps, kS0, 0.2, 7);
+    store16.storePath(0, path.data());
+    CHECK(store16.maxRelativeError() < 2e-6);
+    CHECK(store16.bytes() == ((kSteps * 16 + 63) / 64) * sizeof(std::uint64_t) + sizeof(double));
+
+    // A flat path has no log-returns to scale and decodes exactly
+    CompressedPathStore flat(1, 10, kS0, 8);
+    std::vector<double> constant(11, kS0);
+    flat.storePath(0, constant.data());
+    std::vector<double> out(11);
+    flat.decodePath(0, out.data());
+    for (double price : out) CHECK_NEAR(price, kS0, 1e-12 * kS0);
+
+    // Widths outside [2, 32] are clamped
+    CHECK(CompressedPathStore(1, 10, kS0, 1).bits() == 2);
+    CHECK(CompressedPathStore(1, 10, kS0, 64).bits() == 32);
+}
+
+void testSde() {
+    auto S = stateVar();
+
+    // One Milstein step of GBM: the correction vanishes for dW^2 = dt
+    auto gbm = milsteinScheme(0.05 * S, 0.2 * S);
+    CHECK_NEAR(gbm.step(0.0, 100.0, 0.01, 0.1), 102.05, 1e-12);
+    CHECK_NEAR(gbm.db.eval(0.0, 100.0), 0.2, 1e-15);
+
+    // CEV slope sigma beta S^(beta - 1), zero where the power is clamped
+    const double kSigma = 0.8, kBeta = 0.5;
+    auto cev = milsteinScheme(0.05 * S, kSigma * powPos(S, kBeta));
+    CHECK_NEAR(cev.db.eval(0.0, 4.0), kSigma * kBeta / 2.0, 1e-15);
+    CHECK(cev.db.eval(0.0, 0.0) == 0.0);
+    CHECK(cev.db.eval(0.0, -1.0) == 0.0);
+
+    // The same for sqrtPos, also when the diffusion is nonzero at the clamp
+    auto shifted = milsteinScheme(0.05 * S, 0.3 * sqrtPos(S) + ExprConst{0.1});
+    CHECK_NEAR(shifted.db.eval(0.0, 4.0), 0.3 / 4.0, 1e-15);
+    CHECK(shifted.db.eval(0.0, 0.0) == 0.0);
+    CHECK(shifted.db.eval(0.0, -1.0) == 0.0);
+    CHECK_NEAR(shifted.step(0.0, 0.0, 0.01, 0.1), 0.1 * 0.1, 1e-15);
+
+    // High-volatility CEV paths reach zero; Milstein must stay finite and
+    // agree with Euler on the mean
+    const int kPaths = 4000, kSteps = 200;
+    const double dt = 1.0 / kSteps;
+    auto euler = eulerScheme(0.05 * S, kSigma * powPos(S, kBeta));
+    std::vector<double> x_milstein(kPaths, 1.0), x_euler(kPaths, 1.0), z(kPaths);
+    std::mt19937_64 engine(11);
+    std::normal_distribution<double> normal;
+    for (int i = 0; i < kSteps; ++i) {
+        for (double& zj : z) zj = normal(engine);
+        advanceSde(cev, x_milstein.data(), z.data(), kPaths, i * dt, dt);
+        advanceSde(euler, x_euler.data(), z.data(), kPaths, i * dt, dt);
+    }
+    double mean_milstein = 0.0, mean_euler = 0.0;
+    bool finite = true;
+    for (int j = 0; j < kPaths; ++j) {
+        finite = finite && std::isfinite(x_milstein[j]);
+        mean_milstein += x_milstein[j] / kPaths;
+        mean_euler += x_euler[j] / kPaths;
+    }
+    CHECK(finite);
+    CHECK_NEAR(mean_milstein, mean_euler, 0.05);
+    CHECK_NEAR(mean_milstein, std::exp(0.05), 0.1);
+}
+
+double normalCdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+double blackScholesPut(double S0, double K, double r, double sigma, double T) {
+    double d1 = (std::log(S0 / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T));
+    double d2 = d1 - sigma * std::sqrt(T);
+    return K * std::exp(-r * T) * normalCdf(-d2) - S0 * normalCdf(-d1);
+}
+
+void testLsm() {
+    // A small dense system with a known solution
+    std::vector<double> x;
+    CHECK(solveDense({2, 1, 1, 3}, {5, 10}, 2, x));
+    CHECK_NEAR(x[0], 1.0, 1e-12);
+    CHECK_NEAR(x[1], 3.0, 1e-12);
+    CHECK(!solveDense({1, 2, 2, 4}, {1, 2}, 2, x));
+
+    // The put of Longstaff and Schwartz (2001), table 1: S0 36, K 40, r 6%,
+    // sigma 20%, one year, 50 exercise dates. The finite-difference value is
+    // 4.478 and the European value 3.844.
+    const double kS0 = 36.0, kRate = 0.06, kSigma = 0.2;
+    const int kPaths = 50000, kDates = 50;
+    AmericanOption option;
+    option.strike = 40.0;
+    option.rate = kRate;
+    std::vector<double> times(kDates), prices(static_cast<std::size_t>(kPaths) * kDates);
+    const double dt = 1.0 / kDates;
+    for (int k = 0; k < kDates; ++k) times[k] = (k + 1) * dt;
+    std::mt19937_64 engine(5);
+    std::normal_distribution<double> normal;
+    for (int p = 0; p < kPaths; p += 2) {
+        // Antithetic pairs
+        double log_price[2] = {std::log(kS0), std::log(kS0)};
+        for (int k = 0; k < kDates; ++k) {
+            double z = normal(engine);
+            for (int a = 0; a < 2; ++a) {
+                log_price[a] += (kRate - 0.5 * kSigma * kSigma) * dt + kSigma * std::sqrt(dt) * (a ? -z : z);
+                prices[static_cast<std::size_t>(k) * kPaths + p + a] = std::exp(log_price[a]);
+            }
+        }
+    }
+    LsmResult result = priceLongstaffSchwartz(prices, times, kPaths, kS0, option, 1);
+    CHECK_NEAR(result.price, 4.478, 0.04);
+    CHECK_NEAR(result.european_price, blackScholesPut(kS0, option.strike, kRate, kSigma, 1.0),
+               4 * result.european_std_error);
+    CHECK(result.std_error > 0.0 && result.std_error < 0.02);
+
+    // The regression sums are reduced over fixed chunks
+    LsmResult threaded = priceLongstaffSchwartz(prices, times, kPaths, kS0, option, 3);
+    CHECK(threaded.price == result.price);
+    CHECK(threaded.std_error == result.std_error);
+}
+
+void testBarrier() {
+    // Crossing probability of the bridge: certain at the level, symmetric in
+    // the endpoints and zero without variance
+    CHECK_NEAR(bridgeCrossingProbability(90.0, 100.0, 90.0, 0.01), 1.0, 1e-15);
+    CHECK_NEAR(bridgeCrossingProbability(95.0, 100.0, 90.0, 0.01),
+               std::exp(-2.0 * std::log(90.0 / 95.0) * std::log(0.9) / 0.01), 1e-15);
+    CHECK(bridgeCrossingProbability(95.0, 100.0, 90.0, 0.01) ==
+          bridgeCrossingProbability(100.0, 95.0, 90.0, 0.01));
+    CHECK(bridgeCrossingProbability(95.0, 100.0, 90.0, 0.0) == 0.0);
+
+    // Down-and-out call monitored at 12 dates: the bridge correction recovers
+    // the continuously monitored closed form (Merton; Reiner and Rubinstein),
+    // while the discrete payoff overprices it
+    const double kS0 = 100.0, kRate = 0.05, kSigma = 0.2, kT = 1.0;
+    const int kPaths = 100000, kSteps = 12;
+    BarrierOption option;
+    option.type = BarrierOption::Type::DownOut;
+    option.level = 90.0;
+    option.strike = 100.0;
+    option.rate = kRate;
+
+    const double sqrt_t = kSigma * std::sqrt(kT);
+    const double lambda = (kRate + 0.5 * kSigma * kSigma) / (kSigma * kSigma);
+    const double y = std::log(option.level * option.level / (kS0 * option.strike)) / sqrt_t + lambda * sqrt_t;
+    const double d1 = (std::log(kS0 / option.strike) + (kRate + 0.5 * kSigma * kSigma) * kT) / sqrt_t;
+    const double call = kS0 * normalCdf(d1) - option.strike * std::exp(-kRate * kT) * normalCdf(d1 - sqrt_t);
+    const double ratio = option.level / kS0;
+    const double down_in = kS0 * std::pow(ratio, 2 * lambda) * normalCdf(y) -
+                           option.strike * std::exp(-kRate * kT) * std::pow(ratio, 2 * lambda - 2) *
+                               normalCdf(y - sqrt_t);
+    const double closed_form = call - down_in;
+
+    const double dt = kT / kSteps;
+    std::vector<double> log_variance(kSteps, kSigma * kSigma * dt), path(kSteps + 1);
+    std::mt19937_64 engine(3);
+    std::normal_distribution<double> normal;
+    double discrete_sum = 0.0, continuous_sum = 0.0, continuous_sum_squares = 0.0;
+    for (int p = 0; p < kPaths; ++p) {
+        path[0] = kS0;
+        for (int i = 1; i <= kSteps; ++i) {
+            path[i] = path[i - 1] * std::exp((kRate - 0.5 * kSigma * kSigma) * dt +
+                                             kSigma * std::sqrt(dt) * normal(engine));
+        }
+        double discrete, continuous;
+        barrierPayoff(path.data(), kSteps, log_variance.data(), option, discrete, continuous);
+        discrete_sum += discrete;
+        continuous_sum += continuous;
+        continuous_sum_squares += continuous * continuous;
+    }
+    const double discount = std::exp(-kRate * kT);
+    double continuous_mean = continuous_sum / kPaths;
+    double std_error = std::sqrt((continuous_sum_squares / kPaths - continuous_mean * continuous_mean) / kPaths);
+    CHECK_NEAR(discount * continuous_mean, closed_form, 4 * discount * std_error);
+    CHECK(discount * discrete_sum / kPaths > closed_form + 4 * discount * std_error);
+}
+
+// discard(n) must land where n sequential draws do
+template <typename Engine>
+void checkDiscard(Engine engine) {
+    for (unsigned long long n : {0ull, 1ull, 2ull, 3ull, 7ull, 1000ull, 12345ull}) {
+        Engine sequential = engine, skipped = engine;
+        for (unsigned long long i = 0; i < n; ++i) sequential();
+        skipped.discard(n);
+        CHECK(skipped() == sequential());
+        CHECK(skipped() == sequential());
+    }
+    // fill() continues the same sequence
+    Engine single = engine, bulk = engine;
+    std::vector<typename Engine::result_type> words(9);
+    bulk.fill(words.data(), words.size());
+    bool same = true;
+    for (auto word : words) same = same && word == single();
+    CHECK(same);
+}
+
+void testRng() {
+    // 128-bit arithmetic of PCG64, also without a native 128-bit type
+    Uint128 square = mulWide64(~0ull, ~0ull);
+    CHECK(square.hi == 0xFFFFFFFFFFFFFFFEull && square.lo == 1);
+    Uint128 sum = add128({0, ~0ull}, {0, 1});
+    CHECK(sum.hi == 1 && sum.lo == 0);
+
+    std::seed_seq seq{1u, 2u, 3u};
+    checkDiscard(Pcg64(seq));
+    checkDiscard(Xoshiro256StarStar(seq));
+    checkDiscard(Mt19937(seq));
+    checkDiscard(Philox4x32(42, 7));
+    // Philox discards from the middle of a buffered block
+    Philox4x32 philox(42, 7), reference(42, 7);
+    philox();
+    reference();
+    philox.discard(5);
+    for (int i = 0; i < 5; ++i) reference();
+    CHECK(philox() == reference());
+
+    // Random123 known-answer test: zero counter and key
+    Philox4x32 zero(0, 0);
+    CHECK(zero() == 0xE169C58D6627E8D5ull);
+    CHECK(zero() == 0x9B00DBD8BC57AC4Cull);
+
+    // Normals: batches of any size continue one sequence, and the sample
+    // moments are those of N(0, 1)
+    for (RngEngine engine : {RngEngine::Mt19937, RngEngine::Xoshiro256, RngEngine::Pcg64, RngEngine::Philox4x32}) {
+        std::unique_ptr<NormalStream> whole = makeNormalStream(engine, 9, 3);
+        std::unique_ptr<NormalStream> pieces = makeNormalStream(engine, 9, 3);
+        const std::size_t kCount = 200001;
+        std::vector<double> a(kCount), b(kCount);
+        whole->fill(a.data(), kCount);
+        std::size_t done = 0;
+        for (std::size_t piece = 1; done < kCount; piece = piece * 3 + 1) {
+            std::size_t n = std::min(piece, kCount - done);
+            pieces->fill(b.data() + done, n);
+            done += n;
+        }
+        CHECK(a == b);
+        double mean = 0.0, second = 0.0;
+        for (double z : a) {
+            mean += z / kCount;
+            second += z * z / kCount;
+        }
+        CHECK_NEAR(mean, 0.0, 0.01);
+        CHECK_NEAR(second, 1.0, 0.015);
+    }
+
+    // Streams differ in their high 32 bits too
+    double low = makeNormalStream(RngEngine::Pcg64, 9, 5)->next();
+    double high = makeNormalStream(RngEngine::Pcg64, 9, 5 + (1ull << 32))->next();
+    CHECK(low != high);
+}
+
+void testFastExp() {
+    // Arguments across the normal range, dense around the step sizes the
+    // kernels see
+    std::vector<double> arguments;
+    for (double x = -700.0; x <= 700.0; x += 0.37) arguments.push_back(x);
+    std::mt19937_64 engine(17);
+    std::uniform_real_distribution<double> small(-2.0, 2.0);
+    for (int i = 0; i < 100000; ++i) arguments.push_back(small(engine));
+    arguments.push_back(0.0);
+
+    for (ExpTier tier : {ExpTier::Exact, ExpTier::Tier1e15, ExpTier::Tier1e10, ExpTier::Tier1e6}) {
+        std::vector<double> values = arguments;
+        expInPlace(tier, values.data(), static_cast<int>(values.size()));
+        double max_error = 0.0;
+        for (std::size_t i = 0; i < arguments.size(); ++i) {
+            double exact = std::exp(arguments[i]);
+            max_error = std::max(max_error, std::fabs(values[i] / exact - 1.0));
+        }
+        // The exact tier is std::exp itself
+        CHECK(max_error <= expTierBound(tier));
+    }
+}
+
+// A file in the system temporary directory, removed when it goes out of scope
+struct TemporaryFile {
+    std::string path;
+    explicit TemporaryFile(const std::string& name)
+        : path((std::filesystem::temp_directory_path() / ("mc_unit_" + name)).string()) {}
+    ~TemporaryFile() { std::filesystem::remove(path); }
+};
+
+void testPriceIndex() {
+    // 1000 shuffled prices 1, 2, ..., 1000
+    std::vector<double> prices(1000);
+    for (int i = 0; i < 1000; ++i) prices[i] = i + 1.0;
+    std::shuffle(prices.begin(), prices.end(), std::mt19937_64(2));
+    TerminalPriceIndex index(prices, 2);
+    CHECK(index.size() == 1000);
+    CHECK(index.min() == 1.0 && index.max() == 1000.0);
+    CHECK_NEAR(index.probabilityBelow(500.5), 0.5, 1e-15);
+    CHECK(index.probabilityBelow(1.0) == 0.0);
+    CHECK(index.probabilityBelow(1e9) == 1.0);
+    CHECK(index.quantile(0.25) == 251.0);  // Rank floor(0.25 * 1000)
+    CHECK(index.quantile(0.0) == 1.0);
+    CHECK(index.quantile(1.0) == 1000.0);
+
+    // Save and load round trip
+    TemporaryFile file("index.bin");
+    index.save(file.path);
+    TerminalPriceIndex loaded = TerminalPriceIndex::load(file.path);
+    CHECK(loaded.size() == index.size());
+    bool same = true;
+    for (double p : {0.0, 0.01, 0.5, 0.99, 1.0}) same = same && loaded.quantile(p) == index.quantile(p);
+    CHECK(same);
+
+    // Truncated and foreign files are rejected
+    std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 4);
+    bool truncated_rejected = false;
+    try {
+        TerminalPriceIndex::load(file.path);
+    } catch (const std::runtime_error&) {
+        truncated_rejected = true;
+    }
+    CHECK(truncated_rejected);
+    std::ofstream(file.path, std::ios::trunc) << "not an index";
+    bool foreign_rejected = false;
+    try {
+        TerminalPriceIndex::load(file.path);
+    } catch (const std::runtime_error&) {
+        foreign_rejected = true;
+    }
+    CHECK(foreign_rejected);
+
+    // Prices are kept as floats: within 6e-8 relative
+    TerminalPriceIndex rounded(std::vector<double>{123.456789012345});
+    CHECK_NEAR(rounded.min(), 123.456789012345, 6e-8 * 123.456789012345);
+}
+
+void testRadixSort() {
+    // Keys follow IEEE 754 order, including signed zeros, subnormals and
+    // infinities
+    const double ordered[] = {-std::numeric_limits<double>::infinity(), -1e300, -1.0, -4.9e-324, -0.0, 0.0,
+                              4.9e-324, 1.0, 1e300, std::numeric_limits<double>::infinity()};
+    bool increasing = true;
+    for (std::size_t i = 1; i < std::size(ordered); ++i) {
+        increasing = increasing && radixKey(ordered[i - 1]) < radixKey(ordered[i]);
+    }
+    CHECK(increasing);
+    CHECK(radixKey(-1.0f) < radixKey(-0.0f) && radixKey(0.0f) < radixKey(1.0f));
+
+    // In-memory sorts above the std::sort cutoff agree with std::sort and do
+    // not depend on the thread count
+    std::mt19937_64 engine(23);
+    std::normal_distribution<double> normal(0.0, 50.0);
+    std::vector<double> values(300000);
+    for (double& v : values) v = normal(engine);
+    std::vector<double> expected = values;
+    std::sort(expected.begin(), expected.end());
+    for (int threads : {1, 4}) {
+        std::vector<double> sorted = values;
+        radixSort(sorted, threads);
+        CHECK(sorted == expected);
+    }
+    std::vector<float> floats(values.begin(), values.end());
+    std::vector<float> expected_floats = floats;
+    std::sort(expected_floats.begin(), expected_floats.end());
+    radixSort(floats, 3);
+    CHECK(floats == expected_floats);
+
+    // Out-of-core sort with a budget of 1% of the samples, including a
+    // value repeated more often than the budget holds
+    for (int i = 0; i < 20000; ++i) values[i] = 42.0;
+    expected = values;
+    std::sort(expected.begin(), expected.end());
+    TemporaryFile input("radix_in.bin"), output("radix_out.bin");
+    std::ofstream(input.path, std::ios::binary)
+        .write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    ExternalRadixSorter sorter(values.size() / 100 * sizeof(double), 2,
+                               std::filesystem::temp_directory_path().string());
+    CHECK(sorter.sort(input.path, output.path) == values.size());
+    CHECK(sorter.depth() >= 1);
+    CHECK(sorter.peakValues() <= values.size() / 100);
+    std::vector<double> sorted(values.size());
+    std::ifstream(output.path, std::ios::binary)
+        .read(reinterpret_cast<char*>(sorted.data()), sorted.size() * sizeof(double));
+    CHECK(sorted == expected);
+}
+
+struct TestGroup {
+    const char* name;
+    void (*run)();
+};
+
+const TestGroup kGroups[] = {
+    {"path_store", testPathStore},
+    {"sde", testSde},
+    {"lsm", testLsm},
+    {"barrier", testBarrier},
+    {"rng", testRng},
+    {"fast_exp", testFastExp},
+    {"price_index", testPriceIndex},
+    {"radix_sort", testRadixSort},
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bool found = false;
+    for (const TestGroup& group : kGroups) {
+        if (argc > 1 && std::strcmp(argv[1], group.name) != 0) continue;
+        found = true;
+        int before = failures;
+        group.run();
+        std::printf("%-12s %s\n", group.name, failures == before ? "passed" : "FAILED");
+    }
+    if (!found) {
+        std::printf("Unknown test group %s\n", argv[1]);
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
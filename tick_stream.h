@@ -0,0 +1,76 @@
+#ifndef TICK_STREAM_H
+#define TICK_STREAM_H
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+// Reads price ticks from a local file or named pipe, one tick per line.
+// A line is either a bare price or comma-separated fields whose last field
+// is the price (e.g. "2025-03-08T14:30:00,101.25"). Lines that do not parse
+// to a positive price are skipped.
+//
+// Regular files are tailed like `tail -f`: at end of file the reader polls
+// for appended data instead of stopping. Pipes and other streams end when
+// the writer closes them.
+class TickStream {
+public:
+    explicit TickStream(const std::string& path)
+        : in_(path), follow_(std::filesystem::is_regular_file(path)) {}
+
+    bool isOpen() const { return in_.is_open(); }
+
+    // Block until the next tick arrives. Returns false when the stream ends.
+    bool next(double& price) {
+        std::string line;
+        while (true) {
+            if (std::getline(in_, line)) {
+                if (in_.eof()) {
+                    // Partial line: the writer has not finished it yet
+                    pending_ += line;
+                    in_.clear();
+                    if (!follow_) {
+                        std::string last;
+                        last.swap(pending_);
+                        return parseTick(last, price);
+                    }
+                    waitForData();
+                    continue;
+                }
+                line = pending_ + line;
+                pending_.clear();
+                if (parseTick(line, price)) return true;
+                continue;
+            }
+            if (!follow_) return false;
+            in_.clear();
+            waitForData();
+        }
+    }
+
+private:
+    static bool parseTick(const std::string& line, double& price) {
+        std::size_t start = line.find_last_of(',');
+        start = (start == std::string::npos) ? 0 : start + 1;
+        const char* begin = line.c_str() + start;
+        char* end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end == begin || !(value > 0.0)) return false;
+        price = value;
+        return true;
+    }
+
+    // Poll interval is kept short so a tick is picked up within about a millisecond
+    static void waitForData() {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    std::ifstream in_;
+    bool follow_;
+    std::string pending_;
+};
+
+#endif // TICK_STREAM_H
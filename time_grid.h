@@ -0,0 +1,140 @@
+#ifndef TIME_GRID_H
+#define TIME_GRID_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Days since 1970-01-01 of a proleptic Gregorian date (Howard Hinnant's
+// days_from_civil)
+inline long daysFromCivil(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const long era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    const unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<long>(day_of_era) - 719468;
+}
+
+// Length of a month in the proleptic Gregorian calendar
+inline unsigned daysInMonth(int year, unsigned month) {
+    static const unsigned kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    return month == 2 && leap ? 29 : kDays[month - 1];
+}
+
+// Parse an ISO date (YYYY-MM-DD) into days since 1970-01-01; impossible dates
+// such as 2025-02-30 are rejected
+inline bool parseDate(const std::string& text, long& days) {
+    int year;
+    unsigned month, day;
+    char trailing;
+    if (std::sscanf(text.c_str(), "%d-%u-%u%c", &year, &month, &day, &trailing) != 3) return false;
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) return false;
+    days = daysFromCivil(year, month, day);
+    return true;
+}
+
+// Weekends plus an optional set of holidays. Time on a business-day calendar
+// is measured as business days / 252.
+struct BusinessCalendar {
+    std::set<long> holidays;
+
+    bool isBusinessDay(long day) const {
+        long weekday = ((day % 7) + 7 + 4) % 7;  // 1970-01-01 was a Thursday; 0 = Sunday
+        return weekday != 0 && weekday != 6 && holidays.count(day) == 0;
+    }
+
+    // Business days in (from, to]
+    long businessDaysBetween(long from, long to) const {
+        long count = 0;
+        for (long day = from + 1; day <= to; ++day) {
+            if (isBusinessDay(day)) ++count;
+        }
+        return count;
+    }
+};
+
+const double kBusinessDaysPerYear = 252.0;
+const double kCalendarDaysPerYear = 365.0;
+
+// Load holidays, one ISO date per line
+inline BusinessCalendar loadHolidays(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open holiday file " + path);
+    BusinessCalendar calendar;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        long day;
+        if (!parseDate(line.substr(0, line.find_first_of(" \t\r,")), day)) {
+            throw std::runtime_error("invalid date in " + path + ": " + line);
+        }
+        calendar.holidays.insert(day);
+    }
+    return calendar;
+}
+
+// Load an explicit time grid. Each line is either a time in years or an ISO
+// date; dates are converted to year fractions from the first date, counting
+// business days / 252 when a calendar is given and calendar days / 365
+// otherwise. The grid always starts at t = 0 and must be strictly increasing.
+inline std::vector<double> loadTimeGrid(const std::string& path, const BusinessCalendar* calendar) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open time grid file " + path);
+
+    std::vector<double> grid;
+    bool dates = false;
+    long first_day = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string field = line.substr(0, line.find_first_of(" \t\r,"));
+        if (field.empty() || field[0] == '#') continue;
+
+        double t;
+        long day;
+        if (parseDate(field, day)) {
+            if (grid.empty()) {
+                dates = true;
+                first_day = day;
+            } else if (!dates) {
+                throw std::runtime_error("time grid mixes dates and times in " + path);
+            }
+            t = calendar ? calendar->businessDaysBetween(first_day, day) / kBusinessDaysPerYear
+                         : (day - first_day) / kCalendarDaysPerYear;
+        } else {
+            char* end = nullptr;
+            t = std::strtod(field.c_str(), &end);
+            if (*end != '\0' || dates) throw std::runtime_error("invalid time grid entry in " + path + ": " + line);
+        }
+
+        if (grid.empty() && t > 0.0) grid.push_back(0.0);
+        if (!grid.empty() && t <= grid.back()) {
+            if (grid.size() == 1 && t == 0.0) continue;
+            throw std::runtime_error("time grid must be strictly increasing in " + path + " at: " + line);
+        }
+        grid.push_back(t);
+    }
+    if (grid.size() < 2) throw std::runtime_error("time grid needs at least one step in " + path);
+    return grid;
+}
+
+// Grid with one step per business day from start to end (inclusive), in
+// business days / 252
+inline std::vector<double> businessDayGrid(long start, long end, const BusinessCalendar& calendar) {
+    std::vector<double> grid = {0.0};
+    long count = 0;
+    for (long day = start + 1; day <= end; ++day) {
+        if (calendar.isBusinessDay(day)) {
+            grid.push_back(++count / kBusinessDaysPerYear);
+        }
+    }
+    if (grid.size() < 2) throw std::runtime_error("calendar range contains no business day after the start");
+    return grid;
+}
+
+#endif // TIME_GRID_H